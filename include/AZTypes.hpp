@@ -4,6 +4,7 @@
 
 #include <vector>
 #include <array>
+#include <cstdint>
 
 // your fixed action space size
 static constexpr int ACTION_SIZE = 4672;
@@ -13,6 +14,13 @@ struct TrainingExample {
     std::vector<float>             encodedState;
     std::array<float, ACTION_SIZE> policyTarget;
     int                            valueTarget;
+    uint64_t                       modelVersion = 0;  // ModelInterface::modelVersion() that played the move
+};
+
+/// One entry of a sparse policy: a legal action and its prior probability.
+struct ActionPrior {
+    int   action;
+    float prior;
 };
 
 // A struct to hold game configuration parameters.
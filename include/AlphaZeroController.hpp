@@ -16,6 +16,13 @@ struct ControllerArgs {
     torch::Device                    device;
     double                           learningRate;
     AlphaZeroTrainer::TrainerArgs    trainerArgs;
+    double                           playMoveTimeMs = 0.0;  // time per move in play, 0 = num_searches simulations
+    bool                             quantizedInference = false;  // int8 policy head for MCTS evaluation (CPU)
+    CpuLayout                        cpuLayout = CpuLayout::Contiguous;  // inference layout on CPU
+    int                              intraOpThreads = 0;  // threads per network call; 0 = cores / concurrent callers
+    int                              interOpThreads = 0;  // libtorch inter-op pool (set once per process); 0 = default
+    PolicyHeadType                   policyHead = PolicyHeadType::Dense;  // Conv: 73 planes of 8x8, no 38M-param Linear
+    bool                             watchCheckpoints = false;  // play: reload newer checkpoints of a running trainer between moves
     // Add playerArgs here later
 };
 
@@ -26,12 +33,24 @@ public:
     /// Kicks off the full train‑selfplay‑train loop
     void runTraining();
 
+    /// Sweeps inference layout x batch size x intra-op threads and reports the fastest configuration
+    void runBenchmark();
+
     /// Launches a human vs. AI play loop
+    /// (for now: the engine plays itself with a tree-parallel search and prints each move)
     void runPlay();
 
 private:
     std::unique_ptr<ModelInterface>    modelInterface_;
     std::unique_ptr<AlphaZeroTrainer>  trainer_;
+    AlphaZeroTrainer::TrainerArgs      searchArgs_;   // search settings for play, no root noise
+    double                             playMoveTimeMs_;
+    int                                intraOpThreads_;
+    bool                               watchCheckpoints_;
+
+    /// Split the cores between `workers` concurrent network callers (search threads) and
+    /// libtorch's intra-op pool, unless intraOpThreads was set explicitly.
+    void applyThreadPartition(int workers);
 //    std::unique_ptr<GamePlayer>        player_;
 };
 
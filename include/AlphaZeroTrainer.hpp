@@ -3,12 +3,17 @@
 
 #include <vector>
 #include <array>
+#include <string>
+#include <memory>
 #include "AZTypes.hpp"   // for TrainingExample & ACTION_SIZE
 #include "State.hpp"
+#include "CheckpointManager.hpp"
 //#include "StateEncoder.hpp"
 
 class ModelInterface;    // just a forward declaration
 
+namespace MCTS { class TreePool; }  // forward
+
 class AlphaZeroTrainer {
 public:
     struct TrainerArgs {
@@ -22,19 +27,94 @@ public:
         double dirichlet_alpha;
         double C;
         int    historyLength;
+
+        // Resignation / adjudication (all disabled by default)
+        double resign_threshold      = -1.0;  // resign when the root value drops below this; <= -1 disables
+        double no_resign_fraction    = 0.1;   // fraction of games played out anyway to measure false resigns
+        int    max_game_length       = 0;     // adjudicate a draw after this many plies; 0 disables
+        bool   material_adjudication = false; // adjudicate trivial endings (KQK, KRK, KNNK) via GameStatus
+
+        // Games interleaved on the self-play thread with batched evaluation; 1 plays them one by one
+        int    num_parallel_games    = 1;
+
+        // Workers sharing one tree in MCTS::search (tree-parallel play / analysis); 1 is sequential
+        int    num_search_threads    = 1;
+
+        // Training precision / memory
+        int    micro_batch_size      = 0;     // gradient-accumulation chunk of each batch; 0 runs the batch at once
+        bool   bf16_autocast         = false; // bf16 forward on CPUs with native bf16, fp32 master weights
+        int    num_train_replicas    = 1;     // data-parallel network replicas per batch (one thread each)
+
+        // Checkpointing (see CheckpointManager)
+        std::string checkpoint_dir   = "";    // empty: <project root>/checkpoints
+        int    keep_checkpoints      = 0;     // model checkpoints kept on disk; 0 keeps all
+        bool   share_optimizer_state = false; // only the newest optimizer state (optim_latest.{N}.pt) instead of optim_iter{N}.pt per iteration
+        bool   resume                = false; // continue from the newest checkpoint in checkpoint_dir
+
+        // Gating (see Arena): play the trained candidate against the published model and only
+        // publish it if it wins the SPRT. 0 games publishes after every iteration without a match.
+        int    gating_max_games      = 0;     // match length cap
+        double gating_elo1           = 30.0;  // SPRT H1 (H0 is Elo 0)
+        double gating_alpha          = 0.05;  // false-promotion rate
+        double gating_beta           = 0.05;  // false-rejection rate
+        int    gating_opening_plies  = 8;     // plies sampled from visit counts before greedy play
+
+        // Search tree memory (see TreeAllocator.hpp). Trees are always recycled through a pool.
+        bool   tree_huge_pages       = false; // back large arenas with transparent huge pages
+        bool   tree_prefault         = false; // fault arena pages in on allocation, and pre-allocate one tree per parallel game
+        int    max_tree_nodes        = 0;     // node budget per tree (at least 2 * 218); full trees prune their least
+                                              // visited subtrees. 0 sizes the tree for num_searches (218 nodes each)
+        bool   transpositions        = false; // search a graph: transposed positions share evaluation and statistics
+        bool   mcts_solver           = false; // propagate proven wins / draws / losses and skip solved subtrees
+
+        // Gumbel root search (see MCTS): for small num_searches, replaces root PUCT and temperature sampling
+        bool   gumbel_root           = false;
+        int    gumbel_considered     = 16;    // actions sampled at the root (k in the paper)
+        double gumbel_c_visit        = 50.0;  // sigma(q) = (c_visit + max visits) * c_scale * q
+        double gumbel_c_scale        = 1.0;
+
+        // Progressive widening (see MCTS): children selectable at first, in prior order; 0 considers all
+        int    widening_children     = 0;
+        double widening_exponent     = 0.5;   // ...plus floor(parent visits ^ exponent)
+    };
+
+    // Counters for resignation and adjudication, reset every iteration by learn().
+    struct ResignStats {
+        int games               = 0;
+        int resigned            = 0;  // games ended by resignation
+        int noResignGames       = 0;  // games where resignation was disabled for verification
+        int wouldHaveResigned   = 0;  // no-resign games in which a player crossed the threshold
+        int falsePositives      = 0;  // ...and that player did not go on to lose
+        int lengthAdjudicated   = 0;
+        int materialAdjudicated = 0;
     };
 
     AlphaZeroTrainer(ModelInterface& modelInterface,
                      TrainerArgs trainerArgs, GameConfig gameConfig);
+    ~AlphaZeroTrainer();
 
     /// runs one episode of self-play, returns training examples
     std::vector<TrainingExample> selfPlay();
 
+    /// plays numGames episodes, keeping up to num_parallel_games in flight on this thread and
+    /// evaluating all of their pending leaves in one batch; returns all training examples
+    std::vector<TrainingExample> selfPlayConcurrent(int numGames);
+
     /// given a batch, calls ModelInterface::trainBatch
     void train(const std::vector<TrainingExample>& memory);
 
     void logCheckpoint(int iteration);
 
+    /// prints resignation / adjudication counters for the current iteration
+    void logResignStats() const;
+
+    /// with quantized inference on, prints policy KL / value error of the int8 network against fp32
+    /// on a sample of fresh self-play positions (not trained on yet)
+    void logQuantizationReport(const std::vector<TrainingExample>& memory);
+
+    /// restores model + optimizer from the newest checkpoint; returns its iteration (0 if there is none)
+    int resume();
+
     /// full loop: selfPlay() + train() repeated num_iterations
     void learn();
 
@@ -43,6 +123,9 @@ private:
     ModelInterface& modelIf_;
     TrainerArgs    trainerArgs_;
     GameConfig     gameConfig_;
+    ResignStats    resignStats_;
+    CheckpointManager checkpoints_;
+    std::unique_ptr<MCTS::TreePool> treePool_;  // search trees shared by self-play and gating games
 
 };
 
@@ -0,0 +1,67 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <memory>
+#include <random>
+#include "AlphaZeroTrainer.hpp"
+#include "ModelInterface.hpp"
+
+// Gating matches between a freshly trained candidate and the currently published (best) model.
+//
+// Up to num_parallel_games games run interleaved on the calling thread, like
+// AlphaZeroTrainer::selfPlayConcurrent: every round the pending leaves of all games are evaluated
+// in two batches, one per network. The search has no root noise and plays the most visited move,
+// except for the first gating_opening_plies plies which are sampled from the visit counts so the
+// games don't all repeat each other. Colours alternate between games.
+//
+// After every game a sequential probability ratio test of H0: Elo = 0 against
+// H1: Elo = gating_elo1 is updated (normal approximation of the game score, as in fishtest);
+// the match stops as soon as it accepts either hypothesis, or after gating_max_games games.
+class Arena {
+public:
+    enum class Decision {
+        AcceptH1,      // candidate is stronger: promote
+        AcceptH0,      // candidate is not stronger: keep the best model
+        Inconclusive   // ran out of games; promoted only if the Elo interval is above 0
+    };
+
+    // Candidate's perspective.
+    struct Result {
+        int      wins   = 0;
+        int      draws  = 0;
+        int      losses = 0;
+        double   elo     = 0.0;   // point estimate
+        double   eloLow  = 0.0;   // 95% confidence interval
+        double   eloHigh = 0.0;
+        double   llr     = 0.0;   // SPRT log-likelihood ratio after the last game
+        Decision decision = Decision::Inconclusive;
+        bool     promote  = false;
+
+        int games() const { return wins + draws + losses; }
+    };
+
+    // Search trees come from treePool if given.
+    Arena(const AlphaZeroTrainer::TrainerArgs& args, ModelInterface& modelInterface,
+          MCTS::TreePool* treePool = nullptr);
+
+    // Play the match and decide whether `candidate` replaces `best`.
+    Result play(const ModelInterface::InferenceModel& candidate, const ModelInterface::InferenceModel& best);
+
+    // --- Statistics (exposed for logging) ---
+
+    // Elo difference for an expected score in (0, 1).
+    static double eloFromScore(double score);
+
+    // Fill elo / eloLow / eloHigh / llr of `result` from its W/D/L counts.
+    static void updateStatistics(Result& result, double elo0, double elo1);
+
+private:
+    class Game;  // one match game, defined in Arena.cpp
+
+    AlphaZeroTrainer::TrainerArgs args_;   // search settings: no root noise
+    ModelInterface&               modelIf_;
+    std::mt19937                  rng_;
+    MCTS::TreePool*               treePool_;
+};
+
+#endif // ARENA_HPP
@@ -0,0 +1,81 @@
+#ifndef CHECKPOINT_MANAGER_HPP
+#define CHECKPOINT_MANAGER_HPP
+
+#include <filesystem>
+#include <future>
+#include <optional>
+#include <string>
+
+// Writes checkpoints on a background thread so training never waits on the disk.
+//
+// The caller hands over already-serialized model / optimizer bytes (a snapshot taken on the
+// training thread, see ModelInterface::serializeModel), so later optimizer steps can't tear a
+// checkpoint. Every file is written to "<name>.tmp", flushed to disk and then renamed over the
+// target, so a crash leaves either the previous file or the new one, never a partial one.
+// The manifest "latest.txt" is replaced last and names the newest complete checkpoint, and the
+// model currently published for self-play and play mode ("best"; with gating, training continues
+// from the newest model even when it lost its match, so the two can differ).
+//
+// Layout of the directory:
+//     model_iter{N}.pt                      one per kept iteration
+//     optim_iter{N}.pt / optim_latest.{N}.pt  per iteration, or only the newest one (shared)
+//     latest.txt                            "iteration N", "model <file>", "optim <file>", "best <file>"
+//
+// The best model file is exempt from retention.
+class CheckpointManager {
+public:
+    struct Entry {
+        int                   iteration = 0;
+        std::filesystem::path model;
+        std::filesystem::path optim;  // empty if the checkpoint has no optimizer state
+        std::filesystem::path best;   // published weights; empty in manifests that predate it
+    };
+
+    // keepLast: number of model checkpoints kept (older ones are deleted), 0 keeps all.
+    // shareOptimizer: keep only the newest optimizer state (optim_latest.{N}.pt; the previous one is
+    // deleted once the manifest names the new one) instead of one per iteration; Adam's two moment
+    // buffers make each optimizer file twice the size of the model.
+    CheckpointManager(std::filesystem::path directory, int keepLast, bool shareOptimizer);
+
+    // Waits for the write in flight.
+    ~CheckpointManager();
+
+    CheckpointManager(const CheckpointManager&) = delete;
+    CheckpointManager& operator=(const CheckpointManager&) = delete;
+
+    // Queue a checkpoint for `iteration`. Returns immediately unless the previous write is still
+    // running, in which case it waits for that one first (at most one snapshot is held in memory).
+    // published: the model is the one now served (it won its gating match, or there is no gating);
+    // otherwise the manifest keeps naming the previous best model.
+    void saveAsync(int iteration, std::string modelBytes, std::string optimBytes, bool published);
+
+    // Block until the pending write (if any) is on disk.
+    void wait();
+
+    // The checkpoint named by the manifest, if there is one and its files exist.
+    std::optional<Entry> latest() const;
+
+    const std::filesystem::path& directory() const { return directory_; }
+
+    // <project root>/checkpoints, the location used when no directory is configured.
+    static std::filesystem::path defaultDirectory();
+
+private:
+    std::filesystem::path directory_;
+    int                   keepLast_;
+    bool                  shareOptimizer_;
+    std::future<void>     pending_;
+
+    // Runs on the background thread.
+    void write(int iteration, const std::string& modelBytes, const std::string& optimBytes, bool published);
+
+    // Delete model (and per-iteration optimizer) files beyond keepLast_ except bestIteration's, shared
+    // optimizer states other than newestIteration's and stale *.tmp files. Only called once the manifest
+    // names newestIteration.
+    void applyRetention(int newestIteration, int bestIteration);
+
+    // Write `bytes` to path.tmp, fsync, rename onto path. Returns false (and logs) on failure.
+    static bool writeAtomically(const std::filesystem::path& path, const std::string& bytes);
+};
+
+#endif // CHECKPOINT_MANAGER_HPP
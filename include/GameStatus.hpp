@@ -12,11 +12,36 @@
 //   - terminated: true if the game is over.
 namespace GameStatus {
 
+    // What the game loop and the search need to know about a position, computed once: the
+    // self-play loop hands the record of the position it just reached to the search of that
+    // position, and search leaves analyze their position a single time.
+    struct Analysis {
+        std::array<bool, 4672> validMoves{};  // only filled if movesGenerated
+        bool movesGenerated = false;          // false if a draw rule ended the game before move generation
+        bool inCheck        = false;          // side to move (only known if movesGenerated)
+        int  value          = 0;              // as evaluateState
+        bool terminal       = false;
+        bool debug          = false;          // getValidMoves found a king capture (corrupt position)
+    };
+
+    // Terminal checks in increasing order of cost; legal moves are only generated if no draw rule
+    // (repetition, fifty moves, insufficient material) already ends the game. value/terminal are
+    // the same as evaluateState's.
+    Analysis analyze(const Chess::State &state);
+
     // Evaluate the given state.
     // If valid_moves is not provided, it is generated using MoveGeneration::getValidMoves(state).
     std::pair<int, bool> evaluateState(const Chess::State &state,
                                        const std::array<bool, 4672> *valid_moves_ptr = nullptr);
 
+    // Adjudicate trivial endings from material alone, tablebase style. Only meant to be called on
+    // states evaluateState has already found non-terminal.
+    // Returns {value, adjudicated} using the same convention as evaluateState:
+    //   - value: 1 if the side that just moved wins, -1 if the side to move wins, 0 for a draw.
+    // Handled: K+Q or K+R against a bare king (win, unless the bare king can take the lone piece)
+    //          and K+N+N against a bare king (draw).
+    std::pair<int, bool> adjudicateMaterial(const Chess::State &state);
+
 }
 
 #endif // GAME_STATUS_HPP
@@ -3,9 +3,14 @@
 
 #include <vector>
 #include <cmath>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <random>
 #include <unordered_map>
 #include "AlphaZeroTrainer.hpp"
 #include "AZTypes.hpp"
+#include "TreeAllocator.hpp"
 #include "State.hpp"
 #include "StateTransition.hpp"
 //#include "MoveGeneration.hpp"
@@ -15,28 +20,80 @@ class ModelInterface;  // forward
 
 namespace MCTS {
 
+    // Expansion protocol used by the tree-parallel search. The sequential search only relies on children.
+    enum ExpansionState : uint8_t {
+        UNEXPANDED = 0,  // leaf nobody has claimed yet
+        EXPANDING  = 1,  // a worker is evaluating / expanding it
+        EXPANDED   = 2,  // children are published and safe to read
+        TERMINAL   = 3   // game over here, terminal_value is cached
+    };
+
+    // Children are created without their position (a copy of the parent's stands in) and get it the
+    // first time selection reaches them, so an expansion doesn't compute 30-50 next states of which PUCT
+    // visits a handful.
+    enum StateReady : uint8_t {
+        STATE_PENDING  = 0,  // state is the parent's, clearMap not known yet
+        STATE_BUILDING = 1,  // a worker is computing it
+        STATE_READY    = 2
+    };
+
+    // Game-theoretic result of a node for its side to move, as established by the MCTS-solver.
+    enum Proof : uint8_t {
+        UNPROVEN    = 0,
+        PROVEN_WIN  = 1,  // some child is a proven loss
+        PROVEN_DRAW = 2,  // every child is proven, the best of them a draw
+        PROVEN_LOSS = 3   // checkmate, or every child is a proven win
+    };
+
     // The Node structure will live in an arena (a std::vector<Node>).
-    // We use integer indices to refer to parent/children.
+    // We use integer indices to refer to parent/children. A node's children are appended together,
+    // so they occupy the contiguous index range [first_child, first_child + num_children).
+    // Search statistics (prior, visits, value sum) don't live here but in MCTS's packed arrays,
+    // indexed like the arena, so selection can scan siblings without touching these large nodes.
     struct Node {
         int action_taken;           // Action that led to this node (for root, can be -1)
-        float prior;                // Prior probability from the policy network (set uniformly if not given)
-        int visit_count;            // Number of visits
-        float value_sum;            // Sum of simulation values
         // Use std::optional<Chess::State> state; in future to allow for lazy initialization
         Chess::State state;         // The game state at this node (by value)
         int parent;                 // Index of the parent node in the arena; -1 for root
-        std::vector<int> children;  // Indices of child nodes in the arena
+        int first_child;            // Index of the first child in the arena; -1 if not expanded
+        int num_children;           // Number of children
         bool clearMap;              // To see if we should clear map at that node
+        std::atomic<uint8_t> expansion;  // ExpansionState
+        uint8_t repetitions;        // Graph search: repetition count of the position the children belong to
+        std::atomic<uint8_t> proof; // Proof (solver); anytime queries read it at the root
+        std::atomic<uint8_t> stateReady;  // StateReady
+        float terminal_value;       // Value for the side to move once expansion == TERMINAL
 
-        Node(const Chess::State& state_, int action_, float prior_, int parentIndex_, bool clearMap_)
-                : action_taken(action_), prior(prior_), visit_count(0), value_sum(0.0f),
-                  state(state_), parent(parentIndex_), clearMap(clearMap_) { }
+        Node(const Chess::State& state_, int action_, int parentIndex_, bool clearMap_,
+             StateReady stateReady_ = STATE_READY)
+                : action_taken(action_), state(state_), parent(parentIndex_),
+                  first_child(-1), num_children(0), clearMap(clearMap_),
+                  expansion(UNEXPANDED), repetitions(0), proof(UNPROVEN), stateReady(stateReady_),
+                  terminal_value(0.0f) { }
 
+        // Atomics aren't copyable; the arena only copies nodes while nobody else is reading them.
+        Node(const Node& other)
+                : action_taken(other.action_taken), state(other.state), parent(other.parent),
+                  first_child(other.first_child), num_children(other.num_children),
+                  clearMap(other.clearMap),
+                  expansion(other.expansion.load(std::memory_order_relaxed)),
+                  repetitions(other.repetitions), proof(other.proof.load(std::memory_order_relaxed)),
+                  stateReady(other.stateReady.load(std::memory_order_relaxed)),
+                  terminal_value(other.terminal_value) { }
 
-        // Returns the average value.
-        inline float meanValue() const {
-            return (visit_count == 0) ? 0.0f : value_sum / static_cast<float>(visit_count);
-
+        Node& operator=(const Node& other) {
+            action_taken = other.action_taken;
+            state = other.state;
+            parent = other.parent;
+            first_child = other.first_child;
+            num_children = other.num_children;
+            clearMap = other.clearMap;
+            expansion.store(other.expansion.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            repetitions = other.repetitions;
+            proof.store(other.proof.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            stateReady.store(other.stateReady.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            terminal_value = other.terminal_value;
+            return *this;
         }
 
         void print(int nodeIdx = -1) const {
@@ -45,33 +102,191 @@ namespace MCTS {
                 std::cout << " ────\n";
                 std::cout << "  action_taken : " << action_taken << "\n";
                 std::cout << "  fromSqure : " << action_taken % 64 << " and moveType: " << action_taken / 64 << "\n";
-                std::cout << "  prior         : " << prior << "\n";
-                std::cout << "  visit_count   : " << visit_count << "\n";
-                std::cout << "  value_sum     : " << value_sum << "\n";
-                std::cout << "  mean_value    : " << meanValue() << "\n";
                 std::cout << "  parent        : " << parent << "\n";
                 std::cout << "  clearMap      : " << (clearMap ? "true" : "false") << "\n";
-                std::cout << "  num_children  : " << children.size() << "\n";
+                std::cout << "  num_children  : " << num_children << "\n";
                 std::cout << "  state:\n";
                 state.print();
                 std::cout << "──────────────────────\n";
             }
     };
 
+    // Budget for one search. A search stops at whichever limit is hit first.
+    struct SearchLimits {
+        int    max_nodes   = 0;     // simulations; 0 = TrainerArgs::num_searches
+        double max_time_ms = 0.0;   // wall-clock budget; 0 = no time limit
+        bool   early_stop  = false; // stop once the most visited root child can't be overtaken
+    };
+
+    // Most legal moves in any chess position, i.e. most children of a node.
+    constexpr int MAX_CHILDREN = 218;
+
+    // Upper bound on the nodes of a search of `simulations` simulations: at most one expansion per
+    // simulation plus the root, each with at most MAX_CHILDREN legal moves.
+    inline size_t maxTreeNodes(int simulations) { return MAX_CHILDREN * (1 + static_cast<size_t>(simulations)); }
+
+    // The arena and the packed statistics arrays of one tree. All four are sized to the same capacity.
+    struct TreeStorage {
+        TreeVector<Node>              nodes;
+        TreeVector<float>             priors;
+        TreeVector<std::atomic<int>>  visits;
+        TreeVector<std::atomic<float>> valueSums;
+
+        size_t capacity() const { return priors.size(); }
+
+        // Room for n nodes. Drops the contents if it has to grow; never call mid-search.
+        void reserve(size_t n);
+    };
+
+    // Recycles tree storage across games and threads. Every game (and every arena game) builds its own
+    // MCTS; without the pool each of them allocates and frees tens of MiB of arena, and the fresh pages
+    // fault in again one by one during the first searches. Storage handed back keeps its capacity and
+    // its pages, and is handed to the next MCTS that asks. Thread-safe.
+    class TreePool {
+    public:
+        // A released storage if there is one, else an empty one (the MCTS sizes it).
+        TreeStorage acquire();
+
+        // Take storage back; its nodes are destroyed, its memory is kept.
+        void release(TreeStorage storage);
+
+        // Allocate `count` trees of `nodes` nodes up front, e.g. one per concurrent game.
+        void prewarm(int count, size_t nodes);
+
+        // Trees currently held by the pool.
+        size_t available() const;
+
+        // Acquisitions served from recycled storage / with fresh storage.
+        long long reused() const  { return reused_.load(std::memory_order_relaxed); }
+        long long created() const { return created_.load(std::memory_order_relaxed); }
+
+    private:
+        mutable std::mutex       mutex_;
+        std::vector<TreeStorage> free_;
+        std::atomic<long long>   reused_{0};
+        std::atomic<long long>   created_{0};
+    };
+
     // The MCTS class implements search over game states using a simple arena.
     // In Option A, the tree is built from scratch each search and discarded.
+    //
+    // Graph search (TrainerArgs::transpositions): a node stands for the edge from its parent, and its
+    // visits / value sum are that edge's statistics. Expanded positions are indexed by zobrist hash,
+    // repetition count and half-move clock; a leaf reaching a known position links to that position's
+    // children instead of expanding its own, and backs up the position's current value without a network
+    // call. Children (and so the statistics below them) are shared by every edge into the position,
+    // simulations are backed up along the selection path rather than parent links, and a node's parent
+    // visit count is the sum of its children's edge visits. The network input history of a transposed
+    // position is that of the path that first expanded it. Used by the sequential search only; the
+    // tree-parallel search and node-budget pruning (a full graph ends the search instead) still build a tree.
+    //
+    // Solver (TrainerArgs::mcts_solver): terminal leaves are proven wins / draws / losses, and proofs
+    // propagate up: a node is won if a child is lost (for the opponent), and lost or drawn once every child
+    // is proven. Selection stops at a solved node and backs up its exact value without regenerating moves,
+    // a solved root ends the search, and the root then only reports the children that achieve its result.
+    // Sequential tree search only: under graph search a proof would depend on the path (repetitions).
+    //
+    // Gumbel root search (TrainerArgs::gumbel_root, Danihelka et al., "Policy improvement by planning with
+    // Gumbel"): instead of PUCT plus root noise, the root samples its gumbel_considered best actions without
+    // replacement (Gumbel-top-k over the prior logits) and splits the simulations between them by sequential
+    // halving, ranking by gumbel + logit + sigma(Q). Below the root the search is unchanged. searchResult()
+    // is then the improved policy softmax(logit + sigma(completed Q)), a training target that is useful at
+    // 16-64 simulations, and bestAction() the action sequential halving picked (the move self-play plays).
+    // Sequential search only.
+    //
+    // Progressive widening (TrainerArgs::widening_children > 0): children are laid out in prior order and
+    // selection only considers the first widening_children + floor(N ^ widening_exponent) of them, N being
+    // the parent's visits. The rest stay unvisited placeholders, and a node with children still outside
+    // the window can't be proven lost or drawn by the solver.
     class MCTS {
     public:
         // Constructor takes configuration (we assume TrainerArgs has at least num_searches and C).
-        MCTS(const AlphaZeroTrainer::TrainerArgs& args, ModelInterface& modelInterface);
+        // With a pool, the tree storage is taken from it and handed back on destruction.
+        MCTS(const AlphaZeroTrainer::TrainerArgs& args, ModelInterface& modelInterface,
+             TreePool* pool = nullptr);
+        ~MCTS();
+
+        MCTS(const MCTS&) = delete;
+        MCTS& operator=(const MCTS&) = delete;
 
         // Search: given a starting state and a reference to a repetition map (mapping state.zobrist_hash to count),
         // perform MCTS search and return a vector (of length action_size) of normalized visit counts (policy).
         std::array<float, ACTION_SIZE> search(const Chess::State& state,
                                   const std::unordered_map<uint64_t, uint8_t>& repetitionMap);
 
+        // Same, bounded by a node and/or time budget instead of a fixed num_searches.
+        std::array<float, ACTION_SIZE> search(const Chess::State& state,
+                                  const std::unordered_map<uint64_t, uint8_t>& repetitionMap,
+                                  const SearchLimits& limits);
+
+        // Value of the most visited root child after the last search, from the perspective of the
+        // player to move at the root. Used by self-play to decide resignations.
+        float rootValue() const;
+
+        // --- Resumable search ---
+        // search() is a loop over these. A caller that owns many searches (the multi-game
+        // scheduler) drives them instead, so it can batch the pending evaluations of all of them.
+        //
+        //   beginSearch(state, repMap);
+        //   while (awaitingEvaluation()) {
+        //       provideEvaluation(<network output for pendingStates(), over pendingLegalActions()>);
+        //   }
+        //   auto probs = searchResult();
+
+        // Reset the tree for a new root. The search then waits for the root's evaluation.
+        void beginSearch(const Chess::State& state,
+                         const std::unordered_map<uint64_t, uint8_t>& repetitionMap,
+                         const SearchLimits& limits = SearchLimits{});
+
+        // Same, reusing the game loop's analysis of `state` (GameStatus::analyze) for the root's legal moves.
+        void beginSearch(const Chess::State& state,
+                         const std::unordered_map<uint64_t, uint8_t>& repetitionMap,
+                         const GameStatus::Analysis& rootAnalysis,
+                         const SearchLimits& limits = SearchLimits{});
+
+        // True while the search is suspended waiting for a network evaluation.
+        bool awaitingEvaluation() const { return phase_ == SearchPhase::AwaitingRoot ||
+                                                 phase_ == SearchPhase::AwaitingLeaf; }
+
+        // The T states (oldest first) the network must evaluate before the search can resume.
+        const std::vector<Chess::State>& pendingStates() const { return pendingStates_; }
+
+        // Legal actions of the position waiting for evaluation.
+        const std::vector<int>& pendingLegalActions() const { return pendingLegalActions_; }
+
+        // Feed the network output for pendingStates() (priors over pendingLegalActions(), as from
+        // ModelInterface::evaluateLegal) and run simulations until the next leaf needs an evaluation
+        // or the simulation budget is spent.
+        void provideEvaluation(const std::vector<ActionPrior>& priors, float value);
+
+        // --- Anytime queries ---
+        // Safe to call between beginSearch() and the end of the search, including from another thread
+        // while search() runs; they read the root's children only once those are published. Not while
+        // beginSearch() resets the tree or a bounded search prunes it (max_tree_nodes): both move nodes.
+
+        // Normalized root visit counts so far.
+        std::array<float, ACTION_SIZE> searchResult() const;
+
+        // Most visited root action so far (Gumbel: the best remaining candidate); -1 before the root is expanded.
+        int bestAction() const;
+
+        // Graph search: simulations of the current (or last) search that reused a transposed position.
+        int transpositionHits() const { return transpositionHits_; }
+
+        // Simulations completed by the current (or last) search.
+        int simulationsDone() const { return simulationsDone_.load(std::memory_order_relaxed); }
+
+        // Ask a running search to return as soon as possible.
+        void stop() { stopRequested_.store(true, std::memory_order_relaxed); }
+
 
     private:
+        enum class SearchPhase { Idle, AwaitingRoot, AwaitingLeaf, Done };
+
+        // Visits (and, on the chooser's side, losses) a worker adds to each node on its path while
+        // its simulation is in flight, steering concurrent workers onto different lines.
+        static constexpr int VIRTUAL_LOSS = 1;
+
         // Taking from TrainerArgs
         ModelInterface& modelIf_;
         int num_searches;
@@ -79,32 +294,222 @@ namespace MCTS {
         int historyLength;
         double dirichlet_epsilon;
         double dirichlet_alpha;
+        int num_search_threads;
+        size_t maxNodes_;  // node budget of a tree (TrainerArgs::max_tree_nodes); 0 = unbounded
+        bool transpositions_;  // TrainerArgs::transpositions
+        bool solver_;          // TrainerArgs::mcts_solver
+        bool gumbel_;          // TrainerArgs::gumbel_root and its parameters
+        int gumbelConsidered_;
+        float gumbelCVisit_;
+        float gumbelCScale_;
+        int wideningChildren_;   // TrainerArgs::widening_children; 0 = every child is selectable
+        double wideningExponent_;
+
+        // Serializes appends to the arena during tree-parallel search. The arena is reserved up front
+        // and never reallocates, so readers of existing nodes don't need it.
+        std::mutex arenaMutex_;
+
+        // Arena and statistics, owned or borrowed from pool_ (returned in the destructor)
+        TreePool*   pool_;
+        TreeStorage tree_;
 
         // Arena for our class
-        std::vector<Node> arena;
+        TreeVector<Node>& arena = tree_.nodes;
+
+        // Packed search statistics, indexed like the arena and sized to its capacity. Accesses are
+        // relaxed atomics; Puct::select reads the visit/value arrays as plain ints/floats, which is
+        // what relaxed loads compile to anyway.
+        TreeVector<float>&              priors_    = tree_.priors;
+        TreeVector<std::atomic<int>>&   visits_    = tree_.visits;      // visits (plus any virtual loss in flight)
+        TreeVector<std::atomic<float>>& valueSums_ = tree_.valueSums;   // sum of simulation values (plus virtual loss)
+
+        // Suspended-search bookkeeping
+        SearchPhase phase_ = SearchPhase::Idle;
+        std::atomic<int> simulationsDone_{0};
+
+        // Budget of the current search
+        SearchLimits limits_;
+        int nodeBudget_ = 0;
+        size_t treeLimit_ = 0;  // nodes this search may use: its worst case, capped by maxNodes_
+        std::chrono::steady_clock::time_point searchStart_;
+        std::atomic<bool> stopRequested_{false};
+        int pendingLeaf_ = -1;
+        std::vector<int> pendingLegalActions_;
+        std::vector<Chess::State> pendingStates_;
+        // Repetition tracking without a map per simulation: the game's positions since its last irreversible
+        // move (one hash per occurrence, from the map given to beginSearch) and the hashes along the current
+        // selection path since its last irreversible move (scratch, reused across simulations).
+        std::vector<uint64_t> rootHistory_;
+        std::vector<uint64_t> pathHashes_;
+
+        // Graph search state of the current search
+        struct Transposition {
+            int   first_child;   // child range of the position
+            int   num_children;
+            float value;         // network value, for the side to move there
+        };
+        bool graphSearch_ = false;  // this search uses the graph (sequential search with transpositions_)
+        bool solving_ = false;      // this search proves results (sequential tree search with solver_)
+
+        // Gumbel root search state of the current search
+        bool gumbelSearch_ = false;         // this search uses it (sequential search with gumbel_)
+        std::mt19937 rng_{std::random_device{}()};  // Gumbel and Dirichlet root noise
+        float rootNetworkValue_ = 0.0f;     // network value of the root, for its side to move
+        std::vector<float> rootGumbel_;     // Gumbel noise per root child (offset from first_child)
+        std::vector<int> considered_;       // root children still in the running
+        int gumbelPhases_ = 1;
+        int gumbelTarget_ = 0;              // visits every considered child gets in the current phase
+        size_t gumbelCursor_ = 0;
+        mutable std::mutex gumbelMutex_;    // the Gumbel root state above, for anytime queries from other threads
+        std::unordered_map<uint64_t, Transposition> transpositionTable_;
+        std::vector<int> path_;          // nodes of the last selection, root first
+        uint8_t rootRepetitions_ = 1;    // occurrences of the root position in the game
+        uint8_t leafRepetitions_ = 1;    // repetition count of the last selected leaf (before the leaf double count)
+        int transpositionHits_ = 0;
 
         // Helper functions:
+        // Reserve room for n nodes in the arena and the statistics arrays. Never call mid-search.
+        void reserveNodes(size_t n);
+
+        // Arena size for a search of `simulations` simulations: maxTreeNodes, capped by the node budget.
+        size_t treeCapacity(int simulations) const;
+
+        // Bounded tree (sequential search only): collapse the least visited expanded subtrees below the
+        // root back into leaves until the tree is down to 3/4 of treeLimit_ (at most treeLimit_ - 2 * MAX_CHILDREN),
+        // then compact the arena. A collapsed node keeps its own visits and value, and is expanded again if
+        // selection returns to it. The root and its children keep their indices and statistics, so the root
+        // policy (searchResult) is the same before and after a prune.
+        void pruneTree();
+
+        // Append a node with fresh statistics; returns its index. Callers serialize appends.
+        int appendNode(const Chess::State& state, int action, float prior, int parent, bool clearMap,
+                       StateReady stateReady = STATE_READY);
+
+        // expandNode for the root, with Dirichlet exploration noise mixed into the priors if
+        // dirichlet_epsilon > 0 (self-play; the arena and play mode turn it off).
+        void expandRoot(const std::vector<ActionPrior>& priors);
+
+        // Append placeholder children of leafIdx (state: a copy of `leafState`), in prior order when widening.
+        // Returns the number appended. Callers serialize appends.
+        int appendChildren(int leafIdx, const Chess::State& leafState, const std::vector<ActionPrior>& priors);
+
+        // Compute a child's state from its parent's if selection reaches it for the first time. Workers
+        // racing for the same child wait for the one building it.
+        void materialize(int childIdx);
+
+        // Children of nodeIdx selection may consider, given its visits (progressive widening).
+        int selectableChildren(int nodeIdx, int parentVisits) const;
+
+        // Returns the average value of node idx.
+        inline float meanValue(int idx) const;
+
+        // Adds to the value sum of node idx (no fetch_add for atomic<float> before C++20).
+        inline void addValue(int idx, float v);
+
+        // Child of an expanded node with the highest UCB score.
+        int selectChild(int nodeIdx) const;
+
         // Selection: starting at rootIdx, traverse children using UCB until a leaf is reached.
-        int selectLeaf(int rootIdx, std::unordered_map<uint64_t, uint8_t>& repetitionMap);
+        // Sets the repeated_state flag of every node on the way from the path's hash stack.
+        int selectLeaf(int rootIdx);
 
-        // Expansion: for node at index leafIdx, expand its children.
-        // Returns true if expansion succeeded (i.e. node was non-terminal), false if terminal.
-        void expandNode(int leafIdx, std::array<float, ACTION_SIZE> policy);
+        // Expansion: for node at index leafIdx, add one child per (action, prior).
+        void expandNode(int leafIdx, const std::vector<ActionPrior>& priors);
 
         // Backpropagation: update node statistics along the path from nodeIdx up to the root.
         void backpropagate(int nodeIdx, float value);
 
+        // Back up a simulation ending at leafIdx, the last node of path_ (graph search: along path_).
+        void backupLeaf(int leafIdx, float value);
+
+        // --- Solver ---
+        // Proof of a node from its children's proofs (UNPROVEN while undecided).
+        Proof proofFromChildren(int nodeIdx) const;
+
+        // Mark leafIdx as `proof` and prove its ancestors as far as that decides them.
+        void propagateProof(int leafIdx, Proof proof);
+
+        // Whether a root child achieves the root's proof. Every child does while the root is unsolved.
+        bool achievesRootProof(int childIdx) const;
+
+        // --- Gumbel root search ---
+        // Sample the root's Gumbel noise and its considered actions once the root is expanded.
+        void beginGumbelRoot(float rootValue);
+
+        // Root child the next simulation goes through: the sequential halving schedule, one visit per
+        // considered child in turn; a phase ends once all of them have its visits.
+        int nextGumbelRootChild();
+
+        // sigma(q) = (c_visit + max child visits) * c_scale * q, for a root-perspective value in [-1, 1].
+        float gumbelSigma(float q, int maxVisits) const;
+
+        // Ranking of a root child: gumbel + logit + sigma(Q).
+        float gumbelScore(int childIdx, int maxVisits) const;
+
+        // Highest root child visit count.
+        int maxRootVisits() const;
+
+        // softmax(logit + sigma(completed Q)) over the root children; unvisited ones use the mixed value.
+        std::array<float, ACTION_SIZE> gumbelPolicy() const;
+
+        // --- Graph search ---
+        // Key of a position with the given repetition count.
+        static uint64_t transpositionKey(const Chess::State& state, uint8_t repetitions);
+
+        // Visits of the position at nodeIdx: one for its evaluation plus its children's edge visits.
+        int positionVisits(int nodeIdx) const;
+
+        // Mean value of a known position for its side to move, over its evaluation and all child edges.
+        float positionValue(const Transposition& position) const;
+
+        // If the leaf's position was expanded before, link the leaf to its children and back up its value.
+        // Returns false if the position is new (it then needs a network evaluation).
+        bool linkTransposition(int leafIdx);
+
         // Build a vector of the previous historyLength states (including current)
         std::vector<Chess::State> getCurrentTStates(int nodeIdx);
 
-        // Updates the state's repeated_state flag using its zobrist hash and the repetition map
-        void updateRepetitionTracking(Chess::State& state, std::unordered_map<uint64_t, uint8_t>& repMap);
+        // How often the last position of pathHashes has occurred: in pathHashes itself and, if sinceRoot
+        // (no irreversible move on the path), in rootHistory_. What ++repetitionMap[hash] used to return.
+        uint8_t repetitionCount(const std::vector<uint64_t>& pathHashes, bool sinceRoot) const;
+
+        // Run simulations until a leaf needs a network evaluation or the budget is spent.
+        void runSimulations();
+
+        // True once the search should end: stop requested, node or time budget spent, or (early_stop)
+        // the leading root child's visit lead exceeds the simulations the budget still allows.
+        bool budgetExhausted() const;
+
+        // Visit counts of the two most visited root children and the action of the first.
+        void topRootChildren(int& bestVisits, int& secondVisits, int& bestAction) const;
+
+
+        // --- Tree-parallel search (num_search_threads > 1, used by search()) ---
+        // Runs num_searches simulations over num_search_threads workers descending the same tree.
+        void searchParallel();
+
+        // One simulation by a tree-parallel worker. path / pathCounts / pathHashes are scratch buffers;
+        // pathCounts holds the repetition count of each path node for this descent (0 = keep the stored flag).
+        void parallelSimulation(std::vector<int>& path, std::vector<uint8_t>& pathCounts,
+                                std::vector<uint64_t>& pathHashes);
+
+        // Build the children of a claimed leaf outside the lock, append them, then publish them.
+        void expandNodeConcurrent(int leafIdx, const Chess::State& leafState,
+                                  const std::vector<ActionPrior>& priors);
+
+        // Backpropagate along a path that carries virtual loss, removing it on the way.
+        void backpropagatePath(const std::vector<int>& path, float value, int virtualLoss = VIRTUAL_LOSS);
+
+        // Remove the virtual loss of a simulation that had to be abandoned.
+        void revertVirtualLoss(const std::vector<int>& path);
+
+        // getCurrentTStates for a worker: repetition flags come from this descent, not the shared nodes.
+        // Empty pathCounts keeps every stored flag (the sequential search sets them while descending).
+        std::vector<Chess::State> getPathTStates(const std::vector<int>& path,
+                                                 const std::vector<uint8_t>& pathCounts) const;
 
         // Debug
         void mctsDebugger(int leafIdx);
-
-        // UCB formula: returns UCB score for a child given parent's visit count.
-        inline float ucbScore(const Node& child, int parentVisits) const;
     };
 
 } // namespace MCTS
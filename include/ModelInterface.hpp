@@ -6,6 +6,11 @@
 #include <vector>
 #include <array>
 #include <random>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <memory>
+#include <cstdint>
 #include "Network.hpp"            // ResNet, GameConfig
 #include "StateEncoder.hpp"       // StateEncoder::encodeState
 #include "MoveGeneration.hpp"     // MoveGeneration::getValidMoves
@@ -17,6 +22,26 @@ class ModelInterface;  // forward, so no circular include
 class ModelInterface {
 public:
     using PolicyArray = std::array<float, ACTION_SIZE>;
+    using SparsePolicy = std::vector<ActionPrior>;   // (action, prior) for the legal actions only
+
+    // Accuracy / speed of the int8 policy head against fp32 (see compareQuantized).
+    struct QuantizationReport {
+        int    positions      = 0;
+        double meanPolicyKL   = 0.0;  // KL(fp32 || int8) of the softmax policies, in nats
+        double maxPolicyKL    = 0.0;
+        double meanValueError = 0.0;  // |v_fp32 - v_int8|
+        double maxValueError  = 0.0;
+        double fp32Ms         = 0.0;  // total forward time over all positions
+        double int8Ms         = 0.0;
+    };
+
+    // A frozen, BN-folded inference copy of model_ and the version it is (or would be) published as.
+    // Immutable once built; published versions are replaced as a whole.
+    struct InferenceModel {
+        FusedResNet net;
+        uint64_t    version = 0;
+    };
+    using InferenceHandle = std::shared_ptr<const InferenceModel>;
 
     // -- Ctor takes your ResNet handle by value (ModuleHolder<ResNetImpl>) --
     ModelInterface(ResNet model,
@@ -29,27 +54,113 @@ public:
                         getEncodedSnapshotAndFlags(const std::vector<Chess::State>& states);
 
     // Encode + forward the network → (policy_probs, value)
+    // Runs the BN-folded inference copy (see FusedResNet) of the last published weights, not the
+    // training module. Safe to call from several search threads at once, also while publishWeights runs.
     std::pair<PolicyArray, float>
     evaluateWithNetwork(const std::vector<Chess::State>& states);
 
+    // Encode + forward a batch of positions in a single network call.
+    // Each entry is the T states for one position, as for evaluateWithNetwork.
+    std::vector<std::pair<PolicyArray, float>>
+    evaluateBatch(const std::vector<std::vector<Chess::State>>& batch);
+
+    // Evaluate with the int8 policy head (FusedResNet quantizeHeads). Only MCTS evaluation is affected,
+    // training always runs the fp32 module. Call between self-play phases, not during searches
+    // (the refold takes model_ as it is, keeping the version number).
+    void setQuantizedInference(bool enabled);
+    bool quantizedInference() const { return quantizedInference_; }
+
+    // CPU memory layout of the inference network (see CpuLayout). Same caveat as setQuantizedInference.
+    void setCpuLayout(CpuLayout layout);
+    CpuLayout cpuLayout() const { return cpuLayout_; }
+
+    // Time the inference network on random [batchSize, C, H, W] inputs; returns positions per second.
+    double benchmarkForward(int batchSize, int iterations);
+
+    // Fold the current weights in `layout` and in Contiguous, run both on the same random batch and
+    // return the largest absolute difference of their policy logits and values.
+    double layoutError(CpuLayout layout, int batchSize = 8);
+
+    // Run the inference network with the fp32 and the int8 policy head over the encoded states of
+    // `positions` and measure the difference. Returns positions = 0 if quantization is unavailable.
+    QuantizationReport compareQuantized(const std::vector<TrainingExample>& positions, int batchSize = 256);
+
+    // Encode + forward, then a masked softmax over legalActions only → (priors of the legal actions, value).
+    // What MCTS uses: no softmax over / copy of all ACTION_SIZE logits and no separate masking pass.
+    std::pair<SparsePolicy, float>
+    evaluateLegal(const std::vector<Chess::State>& states, const std::vector<int>& legalActions);
+
+    // evaluateLegal for a batch of positions in a single network call; legalActions[i] belongs to batch[i].
+    std::vector<std::pair<SparsePolicy, float>>
+    evaluateBatchLegal(const std::vector<std::vector<Chess::State>>& batch,
+                       const std::vector<std::vector<int>>& legalActions);
+
+    // The same with a given model instead of the published one (e.g. an unpublished candidate).
+    std::vector<std::pair<SparsePolicy, float>>
+    evaluateBatchLegal(const std::vector<std::vector<Chess::State>>& batch,
+                       const std::vector<std::vector<int>>& legalActions,
+                       const InferenceModel& model);
+
+    // Numerically stable softmax of logits[a] over a in legalActions (same order).
+    static SparsePolicy maskedSoftmax(const float* logits, const std::vector<int>& legalActions);
+
     // Mask illegal moves & renormalize
     PolicyArray
     maskAndNormalizePolicy(const PolicyArray& rawPolicy,
                            const std::array<bool, ACTION_SIZE>& validMoves);
 
-    // One gradient step on a batch of examples
-    void trainBatch(const std::vector<TrainingExample>& batch);
+    // One gradient step on a batch of examples. Evaluations keep using the published version until publishWeights().
+    // With microBatchSize > 0 the batch is run in chunks of that size whose gradients are accumulated
+    // before the single optimizer step, so peak memory follows the micro-batch, not the batch.
+    // (BatchNorm still normalizes over each micro-batch.)
+    void trainBatch(const std::vector<TrainingExample>& batch, int microBatchSize = 0);
+
+    // Run the training forward pass under bf16 autocast (weights, gradients and optimizer state stay fp32).
+    // Only takes effect on CPUs with native bf16; returns whether it is on.
+    bool setBf16Autocast(bool enabled);
+    bool bf16Autocast() const { return bf16Autocast_; }
 
-    // Dirichlet noise for MCTS root noise injection
-    // Returns: (1-ε)*policy + ε*Dir(alpha)
-    PolicyArray addDirichletNoise(const PolicyArray& policy,
+    // Data-parallel training: trainBatch shards each batch over `count` replicas of the network (this
+    // model and count - 1 copies), one thread each, and sums their gradients before the optimizer step.
+    // The intra-op pool is shared by the replica threads; size it for them beforehand (libtorch's thread
+    // count is process-wide). 1 trains on this model only.
+    void setTrainReplicas(int count);
+    int trainReplicas() const { return static_cast<int>(replicas_.size()) + 1; }
+
+    // Dirichlet noise for MCTS root noise injection, over the legal actions of a sparse policy:
+    // prior = (1-ε)*prior + ε*Dir(alpha)
+    static void addDirichletNoise(SparsePolicy& priors,
                                   double dirichlet_epsilon,
-                                  double dirichlet_alpha);
+                                  double dirichlet_alpha,
+                                  std::mt19937& rng);
+
+    // Versioned weights for inference. publishWeights() folds the current training weights into a new
+    // inference network and atomically swaps it in under the next version number; evaluations already
+    // running finish on the version they started with, later ones see the new one. Nothing waits for
+    // in-flight evaluations, so self-play can keep going while a trainer publishes.
+    // Version 0 is the initial weights; the version is reported to tag training examples with.
+    uint64_t publishWeights();
+    uint64_t modelVersion() const;
+
+    // publishWeights() in two steps, so a candidate can be evaluated before it is published:
+    // foldCandidate() folds model_ as the next version, publish() swaps it in (returns its version).
+    InferenceHandle foldCandidate();
+    uint64_t publish(InferenceHandle model);
 
-    // --- In ModelInterface.hpp (public section) ---
-    // Save model + optimizer state, so you can resume training later.
-    // Files will be named model_iter{iteration}.pt and optim_iter{iteration}.pt
-    void saveCheckpoint(int iteration) const;
+    // The published model (refolded first if the layout or precision changed). Callers hold on
+    // to the returned pointer for the whole forward pass.
+    InferenceHandle inferenceModel();
+
+    // Serialized model / optimizer state (what torch::save would write), for CheckpointManager.
+    // Taken on the training thread, the bytes are a consistent snapshot that can be written out later.
+    std::string serializeModel() const;
+    std::string serializeOptimizer() const;
+
+    // Restore model (and, if optimPath isn't empty, optimizer) state written by serializeModel /
+    // serializeOptimizer, and publish the loaded weights. With publishedPath (another model file, e.g.
+    // the best model of a gated run) those weights are published instead and modelPath is only trained.
+    void loadCheckpoint(const std::string& modelPath, const std::string& optimPath,
+                        const std::string& publishedPath = "");
 
 
 private:
@@ -57,6 +168,34 @@ private:
     std::shared_ptr<torch::optim::Optimizer> optimizer_;
     GameConfig                             config_;
     int                                    historyLength_;
+
+    // Accessed with std::atomic_load / std::atomic_store only.
+    InferenceHandle                        inference_;
+    std::atomic<bool>                      fusedStale_{true};   // layout / precision changed: refold, same version
+    std::mutex                             fusedMutex_;         // serializes folding
+    bool                                   quantizedInference_ = false;
+    CpuLayout                              cpuLayout_ = CpuLayout::Contiguous;
+    bool                                   bf16Autocast_ = false;
+
+    // Training copies of model_ for data-parallel trainBatch (replica 0 is model_ itself).
+    std::vector<ResNet>                    replicas_;
+
+    // Fold model_ as it is now into a new InferenceModel tagged `version`.
+    InferenceHandle foldInferenceModel(uint64_t version);
+
+    // Forward + backward over `count` examples in micro-batches, adding to the gradients of `net`.
+    // Losses are scaled by count / totalCount, i.e. this is one shard of a batch of totalCount examples.
+    void accumulateGradients(ResNet& net, const TrainingExample* examples, int count,
+                             int totalCount, int microBatchSize);
+
+    // Copy model_'s weights and BN buffers into the first `count` replicas and clear their gradients.
+    void syncReplicas(int count);
+
+    // Sum the gradients of the first `count` replicas into model_ and average the BN running statistics.
+    void reduceReplicas(int count);
+
+    // Encode positions (T states each) into one [B, C, H, W] input tensor.
+    torch::Tensor encodeBatch(const std::vector<std::vector<Chess::State>>& batch, std::vector<float>& buffer) const;
 };
 
 #endif // MODEL_INTERFACE_HPP
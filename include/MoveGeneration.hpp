@@ -5,6 +5,7 @@
 #include <array>
 #include <cstdint>
 #include <utility>
+#include <vector>
 
 namespace MoveGeneration {
 
@@ -27,6 +28,9 @@ namespace MoveGeneration {
     // Generates a valid-move mask (of size 4672) for the current state.
     // Each index in the returned std::array<bool,4672> is true if the move is legal.
     std::pair<std::array<bool, 4672>, bool> getValidMoves(const Chess::State &state);
+
+    // The legal actions of a valid-move mask, in increasing order.
+    std::vector<int> getLegalActions(const std::array<bool, 4672> &validMoves);
 }
 
 #endif // MOVE_GENERATION_HPP
@@ -139,7 +139,7 @@ namespace MoveMapping {
 //
 // For ambiguous shifts (i.e. ±7 and ±6 in sliding and knight moves), we resolve them via the from square’s file (and piece type if applicable).
 //
-    inline int getMovementType(int shift, int fromSquare, int pieceType) {
+    constexpr int getMovementType(int shift, int fromSquare, int pieceType) {
         int index = shift + offset;
         int baseType = reverseMap[index];
         if (baseType != AMBIGUOUS)
@@ -190,6 +190,90 @@ namespace MoveMapping {
         }
     }
 
+// -------------------------------- Action tables --------------------------------
+// Actions are moveType * 64 + fromSquare. Move generation encodes every candidate move and the
+// transitions decode every action they apply, so both directions are tabulated at compile time
+// from the functions above (tests/test_action_table.cpp checks them against each other).
+
+    static constexpr int ACTION_COUNT = MOVEMENT_TYPE_COUNT * 64;  // 4672
+
+    // ActionInfo::special
+    static constexpr uint8_t ACTION_PROMOTION   = 0b001;  // movement types 64-72
+    static constexpr uint8_t ACTION_CASTLE_TYPE = 0b010;  // 15 / 43: castling if the king moves
+    static constexpr uint8_t ACTION_DOUBLE_PUSH = 0b100;  // 1: sets en passant if a pawn moves
+
+    struct ActionInfo {
+        int8_t  from;       // fromSquare
+        int8_t  to;         // destination square, -1 if the movement leaves the board
+        uint8_t moveType;
+        uint8_t promotion;  // piece a pawn promotes to (white's), bb::NO_PIECE if none
+        uint8_t special;    // ACTION_* flags
+
+        uint64_t toBitboard() const { return to < 0 ? 0ULL : 1ULL << to; }
+    };
+
+    // Pieces of the promotion movement types, N / B / Q (rook promotions aren't encoded).
+    constexpr int promotionPiece(int moveType) {
+        return (moveType >= 64 && moveType <= 66) ? bb::WHITE_KNIGHT
+             : (moveType >= 67 && moveType <= 69) ? bb::WHITE_BISHOP
+             : (moveType >= 70 && moveType <= 72) ? bb::WHITE_QUEEN
+             : bb::NO_PIECE;
+    }
+
+    static constexpr std::array<ActionInfo, ACTION_COUNT> actionTable = []() constexpr {
+        std::array<ActionInfo, ACTION_COUNT> table = {};
+        for (int action = 0; action < ACTION_COUNT; ++action) {
+            int from = action % 64, moveType = action / 64;
+            // applyMovement shifts a single bit: it falls off the board unless the square is in range
+            int to = from + moveTypeToShift[moveType];
+            int promotion = promotionPiece(moveType);
+            table[action] = ActionInfo{
+                    static_cast<int8_t>(from),
+                    static_cast<int8_t>((to >= 0 && to < 64) ? to : -1),
+                    static_cast<uint8_t>(moveType),
+                    static_cast<uint8_t>(promotion),
+                    static_cast<uint8_t>((promotion != bb::NO_PIECE ? ACTION_PROMOTION : 0) |
+                                         ((moveType == 15 || moveType == 43) ? ACTION_CASTLE_TYPE : 0) |
+                                         (moveType == 1 ? ACTION_DOUBLE_PUSH : 0))};
+        }
+        return table;
+    }();
+
+    // Reverse of actionTable for non-promotions: [knight?][from][to] -> the action getMovementType
+    // assigns the move, -1 if it has none.
+    static constexpr std::array<std::array<std::array<int16_t, 64>, 64>, 2> encodeTable = []() constexpr {
+        std::array<std::array<std::array<int16_t, 64>, 64>, 2> table = {};
+        for (int knight = 0; knight < 2; ++knight) {
+            for (int from = 0; from < 64; ++from) {
+                for (int to = 0; to < 64; ++to) {
+                    int moveType = getMovementType(to - from, from, knight ? bb::WHITE_KNIGHT : bb::WHITE_PAWN);
+                    table[knight][from][to] = static_cast<int16_t>(moveType < 0 ? -1 : moveType * 64 + from);
+                }
+            }
+        }
+        return table;
+    }();
+
+    // Action of moving pieceType (a white piece) from -> to; -1 if the move has no encoding.
+    inline int encodeAction(int from, int to, int pieceType) {
+        return encodeTable[pieceType == bb::WHITE_KNIGHT][from][to];
+    }
+
+    // Promotion movement types by pawn shift (7, 8, 9) and piece (N, B, Q), as getPromotionMovementTypes.
+    static constexpr std::array<std::array<int, 3>, 3> promotionMoveTypes = {{
+            {66, 69, 72},   // shift 7
+            {65, 68, 71},   // shift 8
+            {64, 67, 70}    // shift 9
+    }};
+
+    // The three promotion actions of a pawn move from -> to on the last rank, or {-1, -1, -1}.
+    inline std::array<int, 3> encodePromotions(int from, int to) {
+        int shift = to - from;
+        if (to < 56 || shift < 7 || shift > 9) return {-1, -1, -1};
+        const auto& types = promotionMoveTypes[shift - 7];
+        return {types[0] * 64 + from, types[1] * 64 + from, types[2] * 64 + from};
+    }
+
 } // namespace MoveMapping
 
 #endif // MOVE_MAPPING_HPP
@@ -22,10 +22,17 @@ TORCH_MODULE(ResBlock);
 
 // ----------------------- ResNet ------------------------------
 
+// Policy head architecture.
+enum class PolicyHeadType {
+    Dense,  // conv 128 → flatten → Linear(128*H*W, action_size), ~38M parameters for chess
+    Conv    // conv → 1x1 conv to 73 planes of 8x8; plane p, square s is action p*64 + s (MoveMapping layout)
+};
+
 struct ResNetImpl : torch::nn::Module {
     GameConfig config;
     int num_resBlocks;
     int num_hidden;
+    PolicyHeadType policyHeadType;
 
     // Shared layers.
     torch::nn::Sequential startBlock{ nullptr };
@@ -33,10 +40,88 @@ struct ResNetImpl : torch::nn::Module {
     torch::nn::Sequential policyHead{ nullptr };
     torch::nn::Sequential valueHead{ nullptr };
 
-    ResNetImpl(const GameConfig& config, int num_resBlocks, int num_hidden, torch::Device device);
+    ResNetImpl(const GameConfig& config, int num_resBlocks, int num_hidden, torch::Device device,
+               PolicyHeadType policyHeadType = PolicyHeadType::Dense);
     // Forward function returns a pair: policy logits and value.
     std::pair<torch::Tensor, torch::Tensor> forward(torch::Tensor x);
 };
 TORCH_MODULE(ResNet);
 
+// ----------------------- FusedResNet -------------------------
+
+// Memory layout the inference network runs in on CPU.
+enum class CpuLayout {
+    Contiguous,    // default NCHW
+    ChannelsLast,  // NHWC weights and activations, what oneDNN convolutions prefer
+    Mkldnn         // weights pre-packed into oneDNN's blocked format, activations stay oneDNN tensors
+};
+
+const char* cpuLayoutName(CpuLayout layout);
+
+// Frozen, inference-only copy of a ResNet. Every BatchNorm is folded into the conv before it
+// (running stats, i.e. eval-mode BN), so a block is conv → ReLU → conv → residual add → ReLU with
+// the add and ReLUs done in place, and no module dispatch or autograd bookkeeping on the way.
+// It holds plain tensors: rebuild it with syncFrom() whenever the source network's weights change.
+//
+// With quantizeHeads, the dense policy Linear (128*H*W → action_size, by far the largest layer) runs
+// with dynamically quantized int8 weights through fbgemm: per-tensor weight scale, activations quantized
+// on the fly. Only available on CPUs fbgemm supports; otherwise the head stays fp32. A Conv policy head
+// has no Linear and is never quantized.
+class FusedResNet {
+public:
+    // Fold the current weights and BN statistics of `net`, storing the convs in `layout`.
+    // Non-default layouts need a CPU model (Mkldnn also a libtorch built with MKLDNN); otherwise Contiguous is used.
+    void syncFrom(ResNetImpl& net, bool quantizeHeads = false, CpuLayout layout = CpuLayout::Contiguous);
+
+    bool ready() const { return ready_; }
+    bool quantized() const { return quantizedHeads_; }
+    CpuLayout layout() const { return layout_; }
+
+    // Same outputs as ResNetImpl::forward in eval mode: (policy logits, value).
+    // useInt8 = false runs the fp32 policy head even when quantized (for accuracy comparisons).
+    std::pair<torch::Tensor, torch::Tensor> forward(torch::Tensor x, bool useInt8 = true) const;
+
+private:
+    // A convolution (3x3, padding 1 unless noted) with its BatchNorm folded in.
+    struct FusedConv {
+        torch::Tensor weight;
+        torch::Tensor bias;
+    };
+
+    static FusedConv fold(const torch::nn::Conv2dImpl& conv, const torch::nn::BatchNorm2dImpl& bn);
+
+    // Move a folded conv's weight into layout_.
+    FusedConv toLayout(FusedConv c, int64_t padding = 1) const;
+
+    // Stride 1 convolution in layout_ (input already in layout_).
+    torch::Tensor conv(const torch::Tensor& x, const FusedConv& c, int64_t padding = 1) const;
+
+    // Dense NCHW view of an activation, for the Linear heads.
+    torch::Tensor toDense(const torch::Tensor& x) const;
+
+    // Int8 weights of a Linear, prepacked for fbgemm.
+    struct Int8Linear {
+        torch::Tensor weight;      // int8 values
+        torch::Tensor packed;
+        torch::Tensor colOffsets;
+        double        scale = 1.0;
+        int64_t       zeroPoint = 0;
+    };
+
+    static Int8Linear quantizeLinear(const torch::Tensor& weight);
+
+    bool ready_ = false;
+    bool quantizedHeads_ = false;
+    CpuLayout layout_ = CpuLayout::Contiguous;
+    FusedConv start_;
+    std::vector<std::pair<FusedConv, FusedConv>> blocks_;
+    PolicyHeadType policyHeadType_ = PolicyHeadType::Dense;
+    FusedConv policyConv_;
+    FusedConv policyPlanes_;                   // Conv head only: 1x1 conv to 73 planes, no BatchNorm
+    FusedConv valueConv_;
+    torch::Tensor policyWeight_, policyBias_;  // Dense head only: Linear(128*H*W, action_size)
+    Int8Linear    policyInt8_;                 // used instead of policyWeight_ when quantizedHeads_ (fp32 kept for comparisons)
+    torch::Tensor valueWeight_, valueBias_;    // Linear(64*H*W, 1)
+};
+
 #endif // NETWORK_HPP
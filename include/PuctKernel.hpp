@@ -0,0 +1,31 @@
+#ifndef PUCT_KERNEL_HPP
+#define PUCT_KERNEL_HPP
+
+// PUCT child selection over packed sibling statistics.
+//
+// For children i in [0, count):
+//     Q_i   = (1 - valueSums[i] / visits[i]) / 2        (0.5 if visits[i] == 0)
+//     U_i   = c * priors[i] * sqrtParentVisits / (1 + visits[i])
+//     score = Q_i + U_i
+// and the index of the first child with the highest score is returned (-1 if count == 0).
+//
+// All variants evaluate exactly these float operations in this order, so they pick the same
+// child bit for bit. The AVX2 variant is only compiled on x86 with GCC/Clang and chosen at
+// runtime when the CPU supports it; everything else uses the scalar loop.
+namespace Puct {
+
+    int select(const float* priors, const int* visits, const float* valueSums, int count,
+               float c, float sqrtParentVisits);
+
+    int selectScalar(const float* priors, const int* visits, const float* valueSums, int count,
+                     float c, float sqrtParentVisits);
+
+    // Falls back to selectScalar when AVX2 isn't available.
+    int selectAVX2(const float* priors, const int* visits, const float* valueSums, int count,
+                   float c, float sqrtParentVisits);
+
+    // True if select() dispatches to the AVX2 kernel on this machine.
+    bool hasAVX2();
+}
+
+#endif // PUCT_KERNEL_HPP
@@ -0,0 +1,83 @@
+#ifndef SELF_PLAY_GAME_HPP
+#define SELF_PLAY_GAME_HPP
+
+#include <vector>
+#include <array>
+#include <queue>
+#include <unordered_map>
+#include "AZTypes.hpp"
+#include "AlphaZeroTrainer.hpp"
+#include "GameStatus.hpp"
+#include "MCTS.hpp"
+#include "State.hpp"
+
+class ModelInterface;  // forward
+
+// One self-play game written as a state machine. The game only ever suspends at the
+// network-evaluation boundary of its MCTS, so a single thread can interleave many games
+// and batch their pending evaluations together (see AlphaZeroTrainer::selfPlayConcurrent).
+// Every game owns its own arena (borrowed from the trainer's pool if given) and repetition map,
+// so nothing here needs locking.
+class SelfPlayGame {
+public:
+    SelfPlayGame(const AlphaZeroTrainer::TrainerArgs& args,
+                 ModelInterface& modelInterface,
+                 AlphaZeroTrainer::ResignStats& resignStats,
+                 MCTS::TreePool* treePool = nullptr);
+
+    /// True while the game waits on a network evaluation of pendingStates().
+    bool awaitingEvaluation() const { return !finished_ && mcts_.awaitingEvaluation(); }
+
+    /// The T states (oldest first) to evaluate before the game can resume.
+    const std::vector<Chess::State>& pendingStates() const { return mcts_.pendingStates(); }
+
+    /// Legal actions of that position; the network priors are only needed for these.
+    const std::vector<int>& pendingLegalActions() const { return mcts_.pendingLegalActions(); }
+
+    /// Feed the network output for pendingStates() (priors over pendingLegalActions()). Plays moves
+    /// as searches complete and returns once the game needs another evaluation or is over.
+    void provideEvaluation(const std::vector<ActionPrior>& priors, float value);
+
+    bool finished() const { return finished_; }
+
+    /// Training examples of a finished game (moved out).
+    std::vector<TrainingExample> takeExamples() { return std::move(examples_); }
+
+private:
+    // Local structure to record self-play history. Positions are kept packed (T per move, for the
+    // whole game) and only unpacked to build the training examples.
+    struct SelfPlayRecord {
+        std::vector<Chess::PackedState> states;
+        std::array<float, ACTION_SIZE> actionProbs;
+        int player; // +1, -1
+        uint64_t modelVersion;
+    };
+
+    const AlphaZeroTrainer::TrainerArgs& args_;
+    AlphaZeroTrainer::ResignStats&       resignStats_;
+    ModelInterface&                      modelInterface_;
+    MCTS::MCTS                           mcts_;
+
+    Chess::State                          state_;
+    GameStatus::Analysis                  analysis_;      // of state_, shared with its search
+    std::unordered_map<uint64_t, uint8_t> repetitionMap_;
+    std::queue<Chess::PackedState>        currentTStates_;  // last T positions, oldest first
+    std::vector<SelfPlayRecord>           memory_;
+    int  player_  = 1;
+    int  counter_ = 0;
+
+    bool resignEnabled_     = false;
+    bool noResignGame_      = false;
+    int  wouldHaveResigned_ = 0;  // player (+1, -1) who first crossed the threshold in a no-resign game
+
+    bool finished_ = false;
+    std::vector<TrainingExample> examples_;
+
+    // Record the finished search, pick a move and apply it. Returns true if the game ended.
+    bool playMove();
+
+    // Build training examples; `value` is the outcome from the perspective of player_.
+    void finish(int value);
+};
+
+#endif // SELF_PLAY_GAME_HPP
@@ -36,6 +36,25 @@ namespace Chess {
         unsigned repeated_state : 2;
     };
 
+    // A position in 40 bytes instead of State's 176, for positions that are stored rather than played
+    // from (history windows, game records): the occupied squares, the piece type of each occupied
+    // square as a nibble (in square order, low nibble first), and the flags in one word.
+    // typeAtSquare is rebuilt on unpacking, the hash is kept (it is what repetition and cache lookups use).
+    struct PackedState {
+        uint64_t                occupancy;     // squares with a piece
+        uint64_t                zobrist_hash;
+        std::array<uint8_t, 16> types;         // up to 32 pieces, two per byte
+        uint32_t                flags;         // StateFlags bit fields, see State::pack()
+        int32_t                 total_move_count;
+
+        bool operator==(const PackedState& other) const {
+            return occupancy == other.occupancy && zobrist_hash == other.zobrist_hash && types == other.types &&
+                   flags == other.flags && total_move_count == other.total_move_count;
+        }
+        bool operator!=(const PackedState& other) const { return !(*this == other); }
+    };
+    static_assert(sizeof(PackedState) == 40, "PackedState is meant to stay compact");
+
     // The State class itself, which will be stored by value in a Node.
     class State {
     public:
@@ -62,6 +81,12 @@ namespace Chess {
               const StateFlags& flags_,
               const uint64_t& zobrist_hash_);
 
+        // Unpack a PackedState (see pack()).
+        explicit State(const PackedState& packed);
+
+        // The compact form of this state; State(pack()) gives this state back.
+        [[nodiscard]] PackedState pack() const;
+
         // Computes and returns the Zobrist hash for this state.
         [[nodiscard]] uint64_t computeZobrist() const;
 
@@ -0,0 +1,51 @@
+#ifndef TREE_ALLOCATOR_HPP
+#define TREE_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <vector>
+
+// Memory behind the MCTS node arena and its statistics arrays.
+//
+// A tree for a few hundred simulations is tens of MiB, touched in no particular order, so with
+// 4 KiB pages most node accesses miss the TLB. Blocks of at least kLargeBlock bytes are mapped
+// directly and, with huge pages on, advised as transparent huge pages (Linux); with prefault on,
+// every page is touched when the block is allocated, so the page faults happen there and not
+// in the middle of a search. Smaller blocks come from operator new.
+//
+// The settings are process-wide and meant to be set once at startup (AlphaZeroTrainer does);
+// they only affect blocks allocated afterwards.
+namespace TreeMemory {
+
+    constexpr std::size_t kLargeBlock = std::size_t(2) << 20;  // one x86-64 huge page
+
+    void configure(bool hugePages, bool prefault);
+    bool hugePages();
+    bool prefault();
+
+    void* allocate(std::size_t bytes);
+    void  deallocate(void* p, std::size_t bytes);
+}
+
+// std::allocator replacement routing through TreeMemory. Stateless: any two compare equal, so
+// vectors using it move and swap their buffers like with std::allocator.
+template <class T>
+struct TreeAllocator {
+    using value_type = T;
+
+    TreeAllocator() = default;
+    template <class U>
+    TreeAllocator(const TreeAllocator<U>&) { }
+
+    T* allocate(std::size_t n) { return static_cast<T*>(TreeMemory::allocate(n * sizeof(T))); }
+    void deallocate(T* p, std::size_t n) { TreeMemory::deallocate(p, n * sizeof(T)); }
+
+    template <class U>
+    bool operator==(const TreeAllocator<U>&) const { return true; }
+    template <class U>
+    bool operator!=(const TreeAllocator<U>&) const { return false; }
+};
+
+template <class T>
+using TreeVector = std::vector<T, TreeAllocator<T>>;
+
+#endif // TREE_ALLOCATOR_HPP
@@ -1,4 +1,7 @@
 #include "tests/test_bitboard.hpp"
+#include "tests/test_puct.hpp"
+#include "tests/test_action_table.hpp"
+#include "tests/test_state_pack.hpp"
 #include "AlphaZeroController.hpp"
 #include <iostream>
 #include <string>
@@ -9,12 +12,27 @@ int main(int argc, char* argv[]) {
 
     if (argc < 2) {
         std::cerr << "Usage: " << argv[0] << " <mode>\n"
-                  << "  mode = train | play\n";
+                  << "  mode = train | play | bench | test-puct | test-actions | test-pack\n";
         return 1;
     }
 
     std::string mode = argv[1];
 
+    if (mode == "test-puct") {
+        run_all_puct_tests();
+        return 0;
+    }
+
+    if (mode == "test-actions") {
+        run_all_action_table_tests();
+        return 0;
+    }
+
+    if (mode == "test-pack") {
+        run_all_state_pack_tests();
+        return 0;
+    }
+
     // ── TODO: Populate these with real values or parse additional CLI args ──
     ControllerArgs args = {
             /* gameConfig */       {8, 8, 8, 4672},
@@ -32,8 +50,44 @@ int main(int argc, char* argv[]) {
                                            0.25,  // dirichlet_epsilon
                                            0.03,  // dirichlet_alpha
                                            1.41,   // C
-                                           8      // historyLength
-                                   }
+                                           8,     // historyLength
+                                           -1.0,  // resign_threshold
+                                           0.1,   // no_resign_fraction
+                                           0,     // max_game_length
+                                           false, // material_adjudication
+                                           1,     // num_parallel_games
+                                           1,     // num_search_threads
+                                           0,     // micro_batch_size
+                                           false, // bf16_autocast
+                                           1,     // num_train_replicas
+                                           "",    // checkpoint_dir
+                                           0,     // keep_checkpoints
+                                           false, // share_optimizer_state
+                                           false, // resume
+                                           0,     // gating_max_games
+                                           30.0,  // gating_elo1
+                                           0.05,  // gating_alpha
+                                           0.05,  // gating_beta
+                                           8,     // gating_opening_plies
+                                           false, // tree_huge_pages
+                                           false, // tree_prefault
+                                           0,     // max_tree_nodes
+                                           false, // transpositions
+                                           false, // mcts_solver
+                                           false, // gumbel_root
+                                           16,    // gumbel_considered
+                                           50.0,  // gumbel_c_visit
+                                           1.0,   // gumbel_c_scale
+                                           0,     // widening_children
+                                           0.5    // widening_exponent
+                                   },
+            /* playMoveTimeMs */   0.0,
+            /* quantizedInference */ false,
+            /* cpuLayout */        CpuLayout::Contiguous,
+            /* intraOpThreads */   0,
+            /* interOpThreads */   0,
+            /* policyHead */       PolicyHeadType::Dense,
+            /* watchCheckpoints */ false
     };
     // ───────────────────────────────────────────────────────────────────────
 
@@ -43,6 +97,8 @@ int main(int argc, char* argv[]) {
         controller.runTraining();
     } else if (mode == "play") {
         controller.runPlay();
+    } else if (mode == "bench") {
+        controller.runBenchmark();
     } else {
         std::cerr << "Unknown mode: " << mode << "\n";
         return 1;
@@ -1,8 +1,28 @@
 #include "AlphaZeroController.hpp"
+#include "MCTS.hpp"
+#include "StateTransition.hpp"
+#include "GameStatus.hpp"
+
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+AlphaZeroController::AlphaZeroController(const ControllerArgs& args)
+        : searchArgs_(args.trainerArgs),
+          playMoveTimeMs_(args.playMoveTimeMs),
+          intraOpThreads_(args.intraOpThreads),
+          watchCheckpoints_(args.watchCheckpoints) {
+    // Play wants the strongest move, not exploration
+    searchArgs_.dirichlet_epsilon = 0.0;
+
+    // The inter-op pool can only be sized before libtorch first uses it.
+    if (args.interOpThreads > 0) at::set_num_interop_threads(args.interOpThreads);
 
-AlphaZeroController::AlphaZeroController(const ControllerArgs& args) {
     // 1) Build your ResNet + optimizer
-    ResNet net(args.gameConfig, args.numResBlocks, args.numHidden, args.device);
+    ResNet net(args.gameConfig, args.numResBlocks, args.numHidden, args.device, args.policyHead);
     auto opt = std::make_shared<torch::optim::Adam>(net->parameters(), args.learningRate);
 
     // 2) Wrap in ModelInterface
@@ -12,16 +32,154 @@ AlphaZeroController::AlphaZeroController(const ControllerArgs& args) {
             args.gameConfig,
             args.trainerArgs.historyLength
     );
+    modelInterface_->setQuantizedInference(args.quantizedInference);
+    modelInterface_->setCpuLayout(args.cpuLayout);
 
     // 3) Build trainer & player
     trainer_ = std::make_unique<AlphaZeroTrainer>(*modelInterface_, args.trainerArgs, args.gameConfig);
 //    player_  = std::make_unique<GamePlayer>(*modelInterface_ /*, player‑specific args*/);
 }
 
+void AlphaZeroController::applyThreadPartition(int workers) {
+    int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int intra = (intraOpThreads_ > 0) ? intraOpThreads_ : std::max(1, cores / std::max(1, workers));
+    torch::set_num_threads(intra);
+    std::cout << "[threads] " << workers << " network caller(s) x " << intra << " intra-op thread(s), "
+              << at::get_num_interop_threads() << " inter-op, " << cores << " cores\n";
+}
+
 void AlphaZeroController::runTraining() {
+    // Self-play evaluates from a single thread (batched across games), so it gets every core, unless
+    // training shards its batches over replica threads: the intra-op thread count is process-wide and
+    // can't be changed once libtorch has started parallel work, so it is split between them up front.
+    applyThreadPartition(std::max(1, searchArgs_.num_train_replicas));
     trainer_->learn();
 }
 
+void AlphaZeroController::runBenchmark() {
+    int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<int> threadCounts;
+    for (int t = 1; t < cores; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(cores);
+
+    const CpuLayout layouts[] = {CpuLayout::Contiguous, CpuLayout::ChannelsLast, CpuLayout::Mkldnn};
+    const int batchSizes[] = {1, 8, 32, 64, 128, 256};
+    const CpuLayout configured = modelInterface_->cpuLayout();
+
+    struct Best { double rate = 0.0; CpuLayout layout = CpuLayout::Contiguous; int threads = 1; };
+    Best overall;
+    int overallBatch = 1;
+
+    // The layouts must compute the same network before their speed means anything.
+    constexpr double kLayoutTolerance = 1e-3;
+    for (CpuLayout layout : layouts) {
+        if (layout == CpuLayout::Contiguous) continue;
+        double error = modelInterface_->layoutError(layout);
+        std::cout << "[bench] " << cpuLayoutName(layout) << " vs contiguous: max |diff| " << error
+                  << (error <= kLayoutTolerance ? " ok\n" : " MISMATCH\n");
+    }
+
+    std::cout << "[bench] layout, batch, intra-op threads -> positions/s\n";
+    for (int batch : batchSizes) {
+        Best best;
+        for (CpuLayout layout : layouts) {
+            modelInterface_->setCpuLayout(layout);
+            for (int threads : threadCounts) {
+                torch::set_num_threads(threads);
+                int iterations = std::max(3, 512 / batch);
+                double rate = modelInterface_->benchmarkForward(batch, iterations);
+                std::cout << "[bench] " << cpuLayoutName(layout) << ", " << batch << ", " << threads
+                          << " -> " << static_cast<int>(rate) << "\n";
+                if (rate > best.rate) best = {rate, layout, threads};
+            }
+        }
+        std::cout << "[bench] Best for batch " << batch << ": " << cpuLayoutName(best.layout) << " with "
+                  << best.threads << " thread(s), " << static_cast<int>(best.rate) << " positions/s\n";
+        if (best.rate > overall.rate) {
+            overall = best;
+            overallBatch = batch;
+        }
+    }
+
+    // With W concurrent callers each gets cores / W threads, so the per-batch bests above also
+    // tell how to split the machine between search workers and intra-op threads.
+    std::cout << "[bench] Fastest: " << cpuLayoutName(overall.layout) << ", batch " << overallBatch
+              << ", " << overall.threads << " intra-op thread(s): " << static_cast<int>(overall.rate)
+              << " positions/s\n";
+
+    modelInterface_->setCpuLayout(configured);
+}
+
 void AlphaZeroController::runPlay() {
 //    player_->playLoop();
+    // Every search worker calls the network on its own
+    applyThreadPartition(searchArgs_.num_search_threads);
+    MCTS::MCTS searcher(searchArgs_, *modelInterface_);
+
+    Chess::State state;
+    std::unordered_map<uint64_t, uint8_t> repetitionMap;
+    repetitionMap[state.zobrist_hash] = 1;
+
+    // Clock-driven search: num_searches still caps the tree (the arena is sized for it), but we
+    // stop earlier at the time limit or once the best move can't change anymore.
+    MCTS::SearchLimits limits;
+    limits.max_time_ms = playMoveTimeMs_;
+    limits.early_stop = true;
+
+    std::cout << "[play] Up to " << searchArgs_.num_searches << " simulations";
+    if (playMoveTimeMs_ > 0.0) std::cout << " or " << playMoveTimeMs_ << "ms";
+    std::cout << " per move on " << searchArgs_.num_search_threads << " thread(s)\n";
+    state.print();
+
+    // Checkpoints of a trainer running in another process; the model it serves is swapped in between moves.
+    std::unique_ptr<CheckpointManager> checkpoints;
+    std::filesystem::path loadedModel;
+    if (watchCheckpoints_) {
+        checkpoints = std::make_unique<CheckpointManager>(
+                searchArgs_.checkpoint_dir.empty() ? CheckpointManager::defaultDirectory()
+                                                   : std::filesystem::path(searchArgs_.checkpoint_dir),
+                0, false);
+    }
+
+    for (int ply = 1; ; ++ply) {
+        if (checkpoints) {
+            auto latest = checkpoints->latest();
+            // The model the trainer serves, not a candidate that lost its gating match
+            std::filesystem::path served = latest ? (latest->best.empty() ? latest->model : latest->best)
+                                                  : std::filesystem::path();
+            if (!served.empty() && served != loadedModel) {
+                try {
+                    modelInterface_->loadCheckpoint(served.string(), "");
+                    loadedModel = served;
+                } catch (const std::exception& e) {
+                    // e.g. removed by the trainer's retention in the meantime; try again next move
+                    std::cerr << "[play] Could not load checkpoint " << served.filename().string() << ": " << e.what() << "\n";
+                }
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto actionProbs = searcher.search(state, repetitionMap, limits);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Greedy move: most visited root child
+        int action = static_cast<int>(std::max_element(actionProbs.begin(), actionProbs.end()) - actionProbs.begin());
+        std::cout << "[play] Ply " << ply << ": action " << action
+                  << " (" << 100.0f * actionProbs[action] << "% of visits, value " << searcher.rootValue() << ")"
+                  << ", " << searcher.simulationsDone() << " sims in " << seconds << "s, "
+                  << static_cast<int>(searcher.simulationsDone() / std::max(seconds, 1e-9)) << " sims/s\n";
+
+        bool clearMap = StateTransition::getNextState(state, action);
+        if (clearMap) repetitionMap.clear();
+        repetitionMap[state.zobrist_hash] += 1;
+        StateTransition::updateRepeatedStateFlag(state, repetitionMap.at(state.zobrist_hash));
+        state.print();
+
+        auto [value, isTerminal] = GameStatus::evaluateState(state);
+        if (isTerminal) {
+            std::cout << "[play] Game over after " << ply << " plies: "
+                      << (value == 0 ? "draw" : "the side that just moved wins") << "\n";
+            break;
+        }
+    }
 }
@@ -1,8 +1,8 @@
 #include "AlphaZeroTrainer.hpp"
-#include "MCTS.hpp"            // Our MCTS module.
-#include "StateTransition.hpp" // Provides getCopyNextState, etc.
-#include "GameStatus.hpp"      // Provides evaluateState.
+#include "SelfPlayGame.hpp"    // Per-game self-play state machine.
 #include "ModelInterface.hpp"
+#include "Arena.hpp"
+#include "MCTS.hpp"
 
 #include <fstream>     // for std::ofstream
 #include <filesystem>  // for std::filesystem
@@ -11,30 +11,11 @@
 #include <iomanip>     // for std::put_time
 #include <sstream>     // for std::ostringstream
 
-#include <queue>
+#include <memory>
 #include <iostream>
 #include <random>
 #include <algorithm>
-
-// -------------------------- Helper: Random Sampling ------------------------
-// Helper: sample an action index from a probability distribution.
-static int sampleAction(const std::vector<float>& probs) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    float total = 0.0f;
-    for (float p : probs) {
-        total += p;
-    }
-    std::uniform_real_distribution<> dis(0.0, total);
-    float r = dis(gen);
-    float cumulative = 0.0f;
-    for (size_t i = 0; i < probs.size(); ++i) {
-        cumulative += probs[i];
-        if (r <= cumulative)
-            return static_cast<int>(i);
-    }
-    return static_cast<int>(probs.size() - 1);
-}
+#include <iterator>
 
 // ---------------------- AlphaZeroTrainer Implementation ---------------------
 AlphaZeroTrainer::AlphaZeroTrainer(ModelInterface& modelInterface,
@@ -42,118 +23,102 @@ AlphaZeroTrainer::AlphaZeroTrainer(ModelInterface& modelInterface,
                                    GameConfig gameConfig)
         : modelIf_(modelInterface),
           trainerArgs_(std::move(trainerArgs)),
-          gameConfig_(std::move(gameConfig)) {
-    // Constructor body if needed
+          gameConfig_(std::move(gameConfig)),
+          checkpoints_(trainerArgs_.checkpoint_dir.empty() ? CheckpointManager::defaultDirectory()
+                                                           : std::filesystem::path(trainerArgs_.checkpoint_dir),
+                       trainerArgs_.keep_checkpoints,
+                       trainerArgs_.share_optimizer_state),
+          treePool_(std::make_unique<MCTS::TreePool>()) {
+    modelIf_.setBf16Autocast(trainerArgs_.bf16_autocast);
+    modelIf_.setTrainReplicas(std::max(1, trainerArgs_.num_train_replicas));
+
+    TreeMemory::configure(trainerArgs_.tree_huge_pages, trainerArgs_.tree_prefault);
+    if (trainerArgs_.tree_prefault) {
+        treePool_->prewarm(std::max(1, trainerArgs_.num_parallel_games), MCTS::maxTreeNodes(trainerArgs_.num_searches));
+    }
 }
 
+AlphaZeroTrainer::~AlphaZeroTrainer() = default;
+
 std::vector<TrainingExample> AlphaZeroTrainer::selfPlay() {
-    // Local structure to record self-play history.
-    struct SelfPlayRecord {
-        std::vector<Chess::State> states;
-        std::array<float, ACTION_SIZE> actionProbs;
-        int player; // +1, -1
-    };
-
-    // Starting player.
-    int player = 1;
-    // Initialize the state using the default constructor (starting position).
-    Chess::State state;
-    // Instantiate a local MCTS searcher for this move.
-    MCTS::MCTS mctsSearcher(trainerArgs_, modelIf_); // Construct with args or configuration as needed.
-
-    // Vector to hold memory
-    std::vector<SelfPlayRecord> memory;
-    // Create an external repetition map: maps a state's Zobrist hash to the count.
-    std::unordered_map<uint64_t, uint8_t> repetitionMap;
-    // Create a queue to hold previous T states
-    std::queue<Chess::State> currentTStates;
-
-    // Populate queue with initial state
-    for (int i = 0; i < trainerArgs_.historyLength; ++i) {
-        currentTStates.push(state);
+    // A single game, evaluated synchronously one position at a time.
+    SelfPlayGame game(trainerArgs_, modelIf_, resignStats_, treePool_.get());
+    while (!game.finished()) {
+        auto [priors, value] = modelIf_.evaluateLegal(game.pendingStates(), game.pendingLegalActions());
+        game.provideEvaluation(priors, value);
     }
+    return game.takeExamples();
+}
 
-    // Insert root state's hash.
-    repetitionMap[state.zobrist_hash] = 1;
-
-    int counter = 0;
+std::vector<TrainingExample> AlphaZeroTrainer::selfPlayConcurrent(int numGames) {
+    const int maxActive = std::max(1, trainerArgs_.num_parallel_games);
 
-//    std::cout << "Printing current state " << counter << " board \n";
-//    state.validateAndPrintBoard();
+    std::vector<TrainingExample> memory;
+    std::vector<std::unique_ptr<SelfPlayGame>> active;
+    active.reserve(maxActive);
 
-    // Each self-play episode runs until game termination.
-    while (true) {
-        counter++;
-//        std::cout << "I'm move: " << counter << " in self play \n";
-//        state.print();
-        // Call mctsSearcher.search(state, repetitionMap)
-        // Assume that mctsSearcher.search accepts the current state and a reference to the repetition map.
-        std::array<float, ACTION_SIZE> actionProbs = mctsSearcher.search(state, repetitionMap);
+    int started = 0, completed = 0;
+    long long evaluations = 0, batches = 0;
 
-        // Create a record and fill it from the queue
-        SelfPlayRecord record;
+    std::vector<std::vector<Chess::State>> batch;
+    std::vector<std::vector<int>> legalActions;
+    std::vector<SelfPlayGame*> waiting;
+    batch.reserve(maxActive);
+    legalActions.reserve(maxActive);
+    waiting.reserve(maxActive);
 
-        /// Handle filling memory with the current entry
-        // Copy all states from currentTStates (FIFO) into the record
-        std::queue<Chess::State> copyQueue = currentTStates;  // work on a copy so we don't destroy original
-        while (!copyQueue.empty()) {
-            record.states.push_back(copyQueue.front());
-            copyQueue.pop();
-        }
-        // Add rest of the data
-        record.actionProbs = actionProbs;
-        record.player = player;
-        // Push the full record into memory
-        memory.push_back(record);
-
-        // Adjust probabilities using temperature.
-        std::vector<float> temperedProbs(actionProbs.size());
-        float sum = 0.0f;
-        for (size_t i = 0; i < actionProbs.size(); ++i) {
-            temperedProbs[i] = std::pow(actionProbs[i], 1.0 / trainerArgs_.temperature);
-            sum += temperedProbs[i];
+    while (completed < numGames) {
+        // Keep the pool topped up with fresh games.
+        while (started < numGames && static_cast<int>(active.size()) < maxActive) {
+            active.push_back(std::make_unique<SelfPlayGame>(trainerArgs_, modelIf_, resignStats_, treePool_.get()));
+            ++started;
         }
-        for (auto &p : temperedProbs)
-            p /= sum;
-
-        // Sample an action.
-        int action = sampleAction(temperedProbs);
-
-        // Update the state using a pure transition function and get clearMap flag
-        bool clearMap = StateTransition::getNextState(state, action);
 
-//        std::cout << "Printing current state " << counter << " board \n";
-//        state.validateAndPrintBoard();
-
-        // If we should clear the repetition map, do so
-        if (clearMap) repetitionMap.clear();
-
-        // Update currentTStates queue with new state
-        currentTStates.pop();
-        currentTStates.push(state);
-
-        // Update the repetition map with the new state's Zobrist hash.
-        repetitionMap[state.zobrist_hash] += 1;
+        // Gather every game's pending position into one batch.
+        batch.clear();
+        legalActions.clear();
+        waiting.clear();
+        for (auto& game : active) {
+            if (game->awaitingEvaluation()) {
+                batch.push_back(game->pendingStates());
+                legalActions.push_back(game->pendingLegalActions());
+                waiting.push_back(game.get());
+            }
+        }
 
-        // Update state.flags.repeated_state using a helper function
-        StateTransition::updateRepeatedStateFlag(state, repetitionMap.at(state.zobrist_hash));
+        // One network call for all of them, then resume each game up to its next leaf.
+        auto results = modelIf_.evaluateBatchLegal(batch, legalActions);
+        evaluations += static_cast<long long>(batch.size());
+        ++batches;
+        for (size_t i = 0; i < waiting.size(); ++i) {
+            waiting[i]->provideEvaluation(results[i].first, results[i].second);
+        }
 
-        // TODO: Check what happens here with valid_moves_ptr being nullptr by default
-        // Evaluate terminal state.
-        auto [value, isTerminal] = GameStatus::evaluateState(state);
-        if (isTerminal) {
-            // Build training examples from the history.
-            std::vector<TrainingExample> examples;
-            for (const auto& rec : memory) {
-                int outcome = (rec.player == player) ? value : -value;
-                auto [history, flags] = ModelInterface::getEncodedSnapshotAndFlags(rec.states);
-                examples.push_back({StateEncoder::encodeState(history, flags, trainerArgs_.historyLength), rec.actionProbs, outcome});
+        // Collect finished games.
+        for (auto it = active.begin(); it != active.end();) {
+            if ((*it)->finished()) {
+                auto gameData = (*it)->takeExamples();
+                ++completed;
+                std::cout << "[selfPlay]  Collected " << gameData.size()
+                          << " examples from game " << completed << "\n";
+                memory.insert(memory.end(),
+                              std::make_move_iterator(gameData.begin()),
+                              std::make_move_iterator(gameData.end()));
+                it = active.erase(it);
+            } else {
+                ++it;
             }
-            return examples;
         }
+    }
 
-        player = -player;
+    if (batches > 0) {
+        std::cout << "[selfPlay] " << numGames << " games, " << batches << " batches, mean batch size "
+                  << std::fixed << std::setprecision(1)
+                  << static_cast<double>(evaluations) / static_cast<double>(batches)
+                  << std::defaultfloat << " / " << maxActive << ", trees "
+                  << treePool_->reused() << " recycled / " << treePool_->created() << " allocated\n";
     }
+    return memory;
 }
 
 // Train on one iteration’s worth of self‑play data.
@@ -174,16 +139,26 @@ void AlphaZeroTrainer::train(const std::vector<TrainingExample>& memory) {
         std::cout << "[train] Epoch " << epoch
                   << "/" << trainerArgs_.num_epochs
                   << " — " << N << " examples"
-                  << " in " << trainerArgs_.batch_size << "-sized batches\n";
-
+                  << " in " << trainerArgs_.batch_size << "-sized batches";
+        if (trainerArgs_.micro_batch_size > 0 && trainerArgs_.micro_batch_size < trainerArgs_.batch_size)
+            std::cout << " (micro-batches of " << trainerArgs_.micro_batch_size << ")";
+        std::cout << (modelIf_.bf16Autocast() ? ", bf16" : ", fp32");
+        if (modelIf_.trainReplicas() > 1) std::cout << ", " << modelIf_.trainReplicas() << " replicas";
+        std::cout << "\n";
+
+        auto epochStart = std::chrono::steady_clock::now();
         for (int start = 0; start < N; start += trainerArgs_.batch_size) {
             int end = std::min(start + trainerArgs_.batch_size, N);
             std::vector<TrainingExample> batch(
                     examples.begin() + start,
                     examples.begin() + end
             );
-            modelIf_.trainBatch(batch);
+            modelIf_.trainBatch(batch, trainerArgs_.micro_batch_size);
         }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - epochStart).count();
+        std::cout << "[train] Epoch " << epoch << " took " << std::fixed << std::setprecision(2) << seconds
+                  << " s, " << std::setprecision(1) << (seconds > 0.0 ? N / seconds : 0.0)
+                  << std::defaultfloat << " samples/s\n";
     }
 }
 
@@ -227,7 +202,69 @@ void AlphaZeroTrainer::logCheckpoint(int iteration) {
     logFile.close();
 }
 
+// Print this iteration's resignation / adjudication counters.
+void AlphaZeroTrainer::logResignStats() const {
+    const ResignStats& st = resignStats_;
+    std::cout << "[learn] Games: " << st.games
+              << " | resigned: " << st.resigned
+              << " | length-adjudicated: " << st.lengthAdjudicated
+              << " | material-adjudicated: " << st.materialAdjudicated << "\n";
+    if (st.noResignGames > 0) {
+        double fpRate = st.wouldHaveResigned > 0
+                        ? static_cast<double>(st.falsePositives) / st.wouldHaveResigned
+                        : 0.0;
+        std::cout << "[learn] No-resign games: " << st.noResignGames
+                  << " | would have resigned: " << st.wouldHaveResigned
+                  << " | false positives: " << st.falsePositives
+                  << " (" << std::fixed << std::setprecision(1) << 100.0 * fpRate << "%)"
+                  << std::defaultfloat << "\n";
+    }
+}
+
+// Compare the int8 inference network against fp32 on positions it hasn't been trained on.
+void AlphaZeroTrainer::logQuantizationReport(const std::vector<TrainingExample>& memory) {
+    const size_t sampleSize = 512;
+
+    std::vector<TrainingExample> heldOut;
+    if (memory.size() <= sampleSize) {
+        heldOut = memory;
+    } else {
+        std::mt19937_64 rng{std::random_device{}()};
+        std::sample(memory.begin(), memory.end(), std::back_inserter(heldOut), sampleSize, rng);
+    }
+
+    auto report = modelIf_.compareQuantized(heldOut);
+    if (report.positions == 0) {
+        std::cout << "[learn] Quantized inference unavailable, self-play ran fp32\n";
+        return;
+    }
+
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(4)
+        << "[learn] int8 vs fp32 on " << report.positions << " positions"
+        << " | policy KL mean " << report.meanPolicyKL << " max " << report.maxPolicyKL
+        << " | value err mean " << report.meanValueError << " max " << report.maxValueError
+        << std::setprecision(1)
+        << " | forward " << report.int8Ms << "ms vs " << report.fp32Ms << "ms";
+    std::cout << oss.str() << "\n";
+}
+
 // The overall learning loop.
+int AlphaZeroTrainer::resume() {
+    auto entry = checkpoints_.latest();
+    if (!entry) {
+        std::cout << "[resume] No checkpoint in " << checkpoints_.directory().string() << ", starting from scratch\n";
+        return 0;
+    }
+    if (entry->optim.empty()) {
+        std::cerr << "[resume] Checkpoint " << entry->iteration << " has no optimizer state, Adam restarts\n";
+    }
+    // Training continues from the newest model; self-play uses the best one (they differ after a lost gating match).
+    modelIf_.loadCheckpoint(entry->model.string(), entry->optim.string(), entry->best.string());
+    std::cout << "[resume] Resuming after iteration " << entry->iteration << "\n";
+    return entry->iteration;
+}
+
 void AlphaZeroTrainer::learn() {
     std::cout << "[learn] Starting learning: "
               << trainerArgs_.num_iterations << " iterations, "
@@ -236,29 +273,65 @@ void AlphaZeroTrainer::learn() {
     std::cout << "Logging initial start time\n";
     logCheckpoint(0);
 
-    for (int iter = 1; iter <= trainerArgs_.num_iterations; ++iter) {
+    // Self-play data isn't kept across iterations, so the weights, Adam state and the
+    // iteration counter are all there is to restore.
+    int firstIteration = trainerArgs_.resume ? resume() + 1 : 1;
+
+    // With gating, the initial weights stay published until a candidate beats them: checkpoint them
+    // as iteration 0, so a restart before the first promotion still serves them.
+    if (trainerArgs_.gating_max_games > 0 && firstIteration == 1) {
+        checkpoints_.saveAsync(0, modelIf_.serializeModel(), "", true);
+    }
+
+    for (int iter = firstIteration; iter <= trainerArgs_.num_iterations; ++iter) {
         std::cout << "\n[learn] === Iteration " << iter
                   << " of " << trainerArgs_.num_iterations << " ===\n";
 
         // 1) Self‑play: gather multiple full-game examples
+        resignStats_ = ResignStats{};
         std::vector<TrainingExample> memory;
-        for (int g = 1; g <= trainerArgs_.num_selfPlay_iterations; ++g) {
-            auto gameData = selfPlay();                     // runs until terminal
-            memory.insert(memory.end(),
-                          gameData.begin(), gameData.end());
-            std::cout << "[learn]  Collected " << gameData.size()
-                      << " examples from game " << g << "\n";
+        if (trainerArgs_.num_parallel_games > 1) {
+            // Interleave many games on this thread, batching their evaluations
+            memory = selfPlayConcurrent(trainerArgs_.num_selfPlay_iterations);
+        } else {
+            for (int g = 1; g <= trainerArgs_.num_selfPlay_iterations; ++g) {
+                auto gameData = selfPlay();                     // runs until terminal
+                memory.insert(memory.end(),
+                              gameData.begin(), gameData.end());
+                std::cout << "[learn]  Collected " << gameData.size()
+                          << " examples from game " << g << "\n";
+            }
         }
         std::cout << "[learn] Total examples: " << memory.size() << "\n";
+        logResignStats();
+        if (modelIf_.quantizedInference()) logQuantizationReport(memory);
 
-        // 2) Train on that memory
+        // 2) Train on that memory, then let self-play switch to the new weights
         train(memory);
+        bool published = true;
+        if (trainerArgs_.gating_max_games > 0) {
+            // ...only if they beat the ones self-play is using. Training continues from the
+            // candidate either way, as in AlphaGo Zero.
+            auto candidate = modelIf_.foldCandidate();
+            Arena arena(trainerArgs_, modelIf_, treePool_.get());
+            auto match = arena.play(*candidate, *modelIf_.inferenceModel());
+            if (match.promote) {
+                std::cout << "[learn] Published model version " << modelIf_.publish(candidate) << "\n";
+            } else {
+                std::cout << "[learn] Kept model version " << modelIf_.modelVersion() << "\n";
+                published = false;
+            }
+        } else {
+            uint64_t version = modelIf_.publishWeights();
+            std::cout << "[learn] Published model version " << version << "\n";
+        }
 
-        // Save model and optimizer here
-        modelIf_.saveCheckpoint(iter);
+        // Snapshot model and optimizer; the files are written while the next self-play runs
+        checkpoints_.saveAsync(iter, modelIf_.serializeModel(), modelIf_.serializeOptimizer(), published);
         logCheckpoint(iter);
-        std::cout << "[learn] Saved checkpoint for iteration " << iter << "\n";
+        std::cout << "[learn] Queued checkpoint for iteration " << iter << "\n";
     }
+    checkpoints_.wait();
 
     std::cout << "[learn] All " << trainerArgs_.num_iterations
               << " iterations complete\n";
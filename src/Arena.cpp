@@ -0,0 +1,244 @@
+#include "Arena.hpp"
+#include "MCTS.hpp"
+#include "StateTransition.hpp"
+#include "GameStatus.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <tuple>
+#include <unordered_map>
+
+// ------------------------------- Arena::Game --------------------------------
+// One match game as a state machine, like SelfPlayGame: it only suspends when the search of the
+// side to move waits on a network evaluation. Each side has its own tree.
+class Arena::Game {
+public:
+    Game(const AlphaZeroTrainer::TrainerArgs& args, ModelInterface& modelInterface,
+         bool candidateIsWhite, std::mt19937& rng, MCTS::TreePool* treePool)
+            : args_(args),
+              rng_(rng),
+              candidateIsWhite_(candidateIsWhite),
+              candidateSearch_(args, modelInterface, treePool),
+              bestSearch_(args, modelInterface, treePool) {
+        repetitionMap_[state_.zobrist_hash] = 1;
+        analysis_ = GameStatus::analyze(state_);
+        mover().beginSearch(state_, repetitionMap_, analysis_);
+    }
+
+    bool finished() const { return finished_; }
+    bool awaitingEvaluation() const { return !finished_ && mover().awaitingEvaluation(); }
+
+    // Whose network the pending position needs.
+    bool candidateToMove() const { return (ply_ % 2 == 0) == candidateIsWhite_; }
+
+    const std::vector<Chess::State>& pendingStates() const { return mover().pendingStates(); }
+    const std::vector<int>& pendingLegalActions() const { return mover().pendingLegalActions(); }
+
+    void provideEvaluation(const std::vector<ActionPrior>& priors, float value) {
+        mover().provideEvaluation(priors, value);
+        while (!mover().awaitingEvaluation()) {
+            if (playMove()) return;
+            mover().beginSearch(state_, repetitionMap_, analysis_);
+        }
+    }
+
+    // +1 candidate won, 0 draw, -1 candidate lost (once finished).
+    int candidateResult() const { return candidateResult_; }
+
+private:
+    const AlphaZeroTrainer::TrainerArgs&  args_;
+    std::mt19937&                         rng_;
+    bool                                  candidateIsWhite_;
+    MCTS::MCTS                            candidateSearch_;
+    MCTS::MCTS                            bestSearch_;
+
+    Chess::State                          state_;
+    GameStatus::Analysis                  analysis_;      // of state_, shared with the mover's search
+    std::unordered_map<uint64_t, uint8_t> repetitionMap_;
+    int  ply_             = 0;
+    bool finished_        = false;
+    int  candidateResult_ = 0;
+
+    MCTS::MCTS& mover() { return candidateToMove() ? candidateSearch_ : bestSearch_; }
+    const MCTS::MCTS& mover() const { return candidateToMove() ? candidateSearch_ : bestSearch_; }
+
+    int chooseAction(const std::array<float, ACTION_SIZE>& visits) {
+        if (ply_ < args_.gating_opening_plies) {
+            std::discrete_distribution<int> dist(visits.begin(), visits.end());
+            return dist(rng_);
+        }
+        return static_cast<int>(std::max_element(visits.begin(), visits.end()) - visits.begin());
+    }
+
+    // Returns true if the game ended.
+    bool playMove() {
+        int action = chooseAction(mover().searchResult());
+        bool moverIsCandidate = candidateToMove();
+
+        bool clearMap = StateTransition::getNextState(state_, action);
+        if (clearMap) repetitionMap_.clear();
+        repetitionMap_[state_.zobrist_hash] += 1;
+        StateTransition::updateRepeatedStateFlag(state_, repetitionMap_.at(state_.zobrist_hash));
+        ++ply_;
+
+        // Values are from the perspective of the side that just moved.
+        analysis_ = GameStatus::analyze(state_);
+        int  value      = analysis_.value;
+        bool isTerminal = analysis_.terminal;
+        if (!isTerminal && args_.material_adjudication) {
+            std::tie(value, isTerminal) = GameStatus::adjudicateMaterial(state_);
+        }
+        // Without a configured limit, still bound the match: a shuffling draw is a draw.
+        int maxLength = (args_.max_game_length > 0) ? args_.max_game_length : 512;
+        if (!isTerminal && ply_ >= maxLength) {
+            value = 0;
+            isTerminal = true;
+        }
+        if (!isTerminal) return false;
+
+        candidateResult_ = moverIsCandidate ? value : -value;
+        finished_ = true;
+        return true;
+    }
+};
+
+// ---------------------------------- Arena -----------------------------------
+Arena::Arena(const AlphaZeroTrainer::TrainerArgs& args, ModelInterface& modelInterface,
+             MCTS::TreePool* treePool)
+        : args_(args),
+          modelIf_(modelInterface),
+          rng_(std::random_device{}()),
+          treePool_(treePool) {
+    // Measure playing strength, not exploration.
+    args_.dirichlet_epsilon = 0.0;
+    args_.gumbel_root = false;   // Gumbel samples its root actions; arena moves are the visit argmax
+    args_.num_search_threads = 1;
+    // transpositions and mcts_solver are kept: they add no noise, and the candidate plays with them.
+}
+
+double Arena::eloFromScore(double score) {
+    score = std::clamp(score, 1e-3, 1.0 - 1e-3);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+void Arena::updateStatistics(Result& result, double elo0, double elo1) {
+    const double n = result.games();
+    if (n == 0) return;
+
+    double score = (result.wins + 0.5 * result.draws) / n;
+
+    // Per-game variance of the score. Half a win and half a loss are added to the counts here so
+    // that a perfect record (variance 0) doesn't make the LLR explode after a handful of games.
+    double w = result.wins + 0.5, d = result.draws, l = result.losses + 0.5;
+    double variance = (w * (1.0 - score) * (1.0 - score) + d * (0.5 - score) * (0.5 - score)
+                       + l * score * score) / (w + d + l);
+
+    double stderrScore = std::sqrt(variance / n);
+    result.elo     = eloFromScore(score);
+    result.eloLow  = eloFromScore(score - 1.96 * stderrScore);
+    result.eloHigh = eloFromScore(score + 1.96 * stderrScore);
+
+    // LLR of H1 (score s1) against H0 (score s0) for normally distributed game scores.
+    double s0 = 1.0 / (1.0 + std::pow(10.0, -elo0 / 400.0));
+    double s1 = 1.0 / (1.0 + std::pow(10.0, -elo1 / 400.0));
+    result.llr = 0.5 * n * (s1 - s0) * (2.0 * score - s0 - s1) / variance;
+}
+
+Arena::Result Arena::play(const ModelInterface::InferenceModel& candidate,
+                          const ModelInterface::InferenceModel& best) {
+    const int maxGames  = std::max(1, args_.gating_max_games);
+    const int maxActive = std::max(1, args_.num_parallel_games);
+    const double elo0 = 0.0, elo1 = args_.gating_elo1;
+    const double lowerBound = std::log(args_.gating_beta / (1.0 - args_.gating_alpha));
+    const double upperBound = std::log((1.0 - args_.gating_beta) / args_.gating_alpha);
+
+    std::cout << "[arena] Candidate v" << candidate.version << " vs best v" << best.version
+              << ": up to " << maxGames << " games, SPRT Elo " << elo0 << " vs " << elo1
+              << " (LLR bounds " << std::fixed << std::setprecision(2) << lowerBound << ", " << upperBound
+              << std::defaultfloat << ")\n";
+
+    Result result;
+    std::vector<std::unique_ptr<Game>> active;
+    active.reserve(maxActive);
+    int started = 0;
+
+    // One batch per network and round.
+    struct Batch {
+        std::vector<std::vector<Chess::State>> states;
+        std::vector<std::vector<int>>          legalActions;
+        std::vector<Game*>                     games;
+
+        void clear() { states.clear(); legalActions.clear(); games.clear(); }
+        void add(Game* game) {
+            states.push_back(game->pendingStates());
+            legalActions.push_back(game->pendingLegalActions());
+            games.push_back(game);
+        }
+    };
+    Batch candidateBatch, bestBatch;
+
+    bool decided = false;
+    while (!decided && result.games() < maxGames) {
+        // Keep the pool topped up; colours alternate.
+        while (started < maxGames && static_cast<int>(active.size()) < maxActive) {
+            active.push_back(std::make_unique<Game>(args_, modelIf_, started % 2 == 0, rng_, treePool_));
+            ++started;
+        }
+
+        candidateBatch.clear();
+        bestBatch.clear();
+        for (auto& game : active) {
+            if (!game->awaitingEvaluation()) continue;
+            (game->candidateToMove() ? candidateBatch : bestBatch).add(game.get());
+        }
+
+        for (auto [batch, model] : {std::make_pair(&candidateBatch, &candidate), std::make_pair(&bestBatch, &best)}) {
+            if (batch->games.empty()) continue;
+            auto results = modelIf_.evaluateBatchLegal(batch->states, batch->legalActions, *model);
+            for (size_t i = 0; i < batch->games.size(); ++i) {
+                batch->games[i]->provideEvaluation(results[i].first, results[i].second);
+            }
+        }
+
+        // Score finished games; stop as soon as the test is decided.
+        for (auto it = active.begin(); it != active.end() && !decided;) {
+            if (!(*it)->finished()) {
+                ++it;
+                continue;
+            }
+            int outcome = (*it)->candidateResult();
+            if (outcome > 0) result.wins++;
+            else if (outcome < 0) result.losses++;
+            else result.draws++;
+            it = active.erase(it);
+
+            updateStatistics(result, elo0, elo1);
+            std::cout << "[arena] Game " << result.games() << ": +" << result.wins << " =" << result.draws
+                      << " -" << result.losses << ", Elo " << std::fixed << std::setprecision(1) << result.elo
+                      << " [" << result.eloLow << ", " << result.eloHigh << "], LLR "
+                      << std::setprecision(2) << result.llr << std::defaultfloat << "\n";
+
+            if (result.llr >= upperBound) {
+                result.decision = Decision::AcceptH1;
+                decided = true;
+            } else if (result.llr <= lowerBound) {
+                result.decision = Decision::AcceptH0;
+                decided = true;
+            }
+        }
+    }
+    // Games still running when the test stopped are abandoned, not scored.
+
+    result.promote = (result.decision == Decision::AcceptH1) ||
+                     (result.decision == Decision::Inconclusive && result.eloLow > elo0);
+
+    std::cout << "[arena] "
+              << (result.decision == Decision::AcceptH1 ? "SPRT accepted H1"
+                  : result.decision == Decision::AcceptH0 ? "SPRT accepted H0"
+                  : "SPRT inconclusive")
+              << " after " << result.games() << " games: "
+              << (result.promote ? "promoting the candidate" : "keeping the best model") << "\n";
+    return result;
+}
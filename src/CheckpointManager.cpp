@@ -0,0 +1,192 @@
+#include "CheckpointManager.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <unistd.h>   // fsync
+
+namespace fs = std::filesystem;
+
+namespace {
+    std::string modelFileName(int iteration) { return "model_iter" + std::to_string(iteration) + ".pt"; }
+    std::string optimFileName(int iteration) { return "optim_iter" + std::to_string(iteration) + ".pt"; }
+    // The shared optimizer state is still written under a new name per iteration: renaming it over the
+    // previous one before the manifest moves on would pair the manifest's model with newer moments.
+    std::string sharedOptimFileName(int iteration) { return "optim_latest." + std::to_string(iteration) + ".pt"; }
+    const char* const kSharedOptimPrefix = "optim_latest.";
+    const char* const kLegacySharedOptimFile = "optim_latest.pt";
+    const char* const kManifestFile    = "latest.txt";
+
+    // Iteration number of "<prefix><N>.pt", or -1 if the name doesn't match.
+    int iterationOf(const std::string& fileName, const std::string& prefix) {
+        if (fileName.size() <= prefix.size() + 3 || fileName.compare(0, prefix.size(), prefix) != 0) return -1;
+        if (fileName.compare(fileName.size() - 3, 3, ".pt") != 0) return -1;
+        std::string digits = fileName.substr(prefix.size(), fileName.size() - prefix.size() - 3);
+        if (digits.empty() || !std::all_of(digits.begin(), digits.end(), ::isdigit)) return -1;
+        return std::stoi(digits);
+    }
+}
+
+CheckpointManager::CheckpointManager(fs::path directory, int keepLast, bool shareOptimizer)
+        : directory_(std::move(directory)), keepLast_(keepLast), shareOptimizer_(shareOptimizer) {
+    std::error_code ec;
+    fs::create_directories(directory_, ec);
+    if (ec) {
+        std::cerr << "[checkpoint] Failed to create " << directory_ << ": " << ec.message() << "\n";
+    }
+}
+
+CheckpointManager::~CheckpointManager() {
+    wait();
+}
+
+fs::path CheckpointManager::defaultDirectory() {
+    // Find the true project root (go up from the build dir)
+    return fs::current_path().parent_path() / "checkpoints";
+}
+
+void CheckpointManager::saveAsync(int iteration, std::string modelBytes, std::string optimBytes, bool published) {
+    wait();
+    pending_ = std::async(std::launch::async,
+                          [this, iteration, model = std::move(modelBytes), optim = std::move(optimBytes), published]() {
+                              write(iteration, model, optim, published);
+                          });
+}
+
+void CheckpointManager::wait() {
+    if (pending_.valid()) pending_.get();
+}
+
+void CheckpointManager::write(int iteration, const std::string& modelBytes, const std::string& optimBytes,
+                              bool published) {
+    auto start = std::chrono::steady_clock::now();
+
+    // The served model: this one, or whichever the manifest already names (writes are serialized).
+    int bestIteration = published ? iteration : -1;
+    if (!published) {
+        auto previous = latest();
+        if (previous && !previous->best.empty()) {
+            bestIteration = iterationOf(previous->best.filename().string(), "model_iter");
+        }
+    }
+
+    fs::path modelPath = directory_ / modelFileName(iteration);
+    if (!writeAtomically(modelPath, modelBytes)) return;
+
+    fs::path optimPath;
+    if (!optimBytes.empty()) {
+        optimPath = directory_ / (shareOptimizer_ ? sharedOptimFileName(iteration) : optimFileName(iteration));
+        if (!writeAtomically(optimPath, optimBytes)) return;
+    }
+
+    // Only now is the checkpoint complete; point the manifest at it. Files it no longer names
+    // (the previous shared optimizer state) are deleted by applyRetention, after the switch.
+    std::ostringstream manifest;
+    manifest << "iteration " << iteration << "\n"
+             << "model " << modelPath.filename().string() << "\n";
+    if (!optimPath.empty()) manifest << "optim " << optimPath.filename().string() << "\n";
+    if (bestIteration >= 0) manifest << "best " << modelFileName(bestIteration) << "\n";
+    if (!writeAtomically(directory_ / kManifestFile, manifest.str())) return;
+
+    applyRetention(iteration, bestIteration);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[checkpoint] Wrote iteration " << iteration << " to " << directory_.string()
+              << " (" << (modelBytes.size() + optimBytes.size()) / (1024 * 1024) << " MiB, "
+              << static_cast<int>(ms) << " ms)\n";
+}
+
+bool CheckpointManager::writeAtomically(const fs::path& path, const std::string& bytes) {
+    fs::path tmp = path;
+    tmp += ".tmp";
+
+    std::FILE* file = std::fopen(tmp.string().c_str(), "wb");
+    if (!file) {
+        std::cerr << "[checkpoint] Failed to open " << tmp << " for writing\n";
+        return false;
+    }
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    ok = (std::fflush(file) == 0) && ok;
+    ok = (::fsync(::fileno(file)) == 0) && ok;   // on disk before the rename makes it visible
+    ok = (std::fclose(file) == 0) && ok;
+
+    std::error_code ec;
+    if (ok) fs::rename(tmp, path, ec);
+    if (!ok || ec) {
+        std::cerr << "[checkpoint] Failed to write " << path << (ec ? ": " + ec.message() : "") << "\n";
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+void CheckpointManager::applyRetention(int newestIteration, int bestIteration) {
+    std::error_code ec;
+    std::vector<int> iterations;
+    std::vector<fs::path> leftovers;
+    for (const auto& entry : fs::directory_iterator(directory_, ec)) {
+        const std::string fileName = entry.path().filename().string();
+        // Leftovers of a write that was interrupted by a crash.
+        if (entry.path().extension() == ".tmp") {
+            leftovers.push_back(entry.path());
+            continue;
+        }
+        // Shared optimizer states the manifest no longer names (older ones, or one whose
+        // checkpoint never got its manifest), and the single file older versions overwrote.
+        if (fileName == kLegacySharedOptimFile) {
+            if (shareOptimizer_) leftovers.push_back(entry.path());
+            continue;
+        }
+        int sharedIteration = iterationOf(fileName, kSharedOptimPrefix);
+        if (sharedIteration >= 0) {
+            if (sharedIteration != newestIteration) leftovers.push_back(entry.path());
+            continue;
+        }
+        int iteration = iterationOf(fileName, "model_iter");
+        if (iteration >= 0) iterations.push_back(iteration);
+    }
+    for (const auto& path : leftovers) fs::remove(path, ec);
+    if (keepLast_ <= 0 || static_cast<int>(iterations.size()) <= keepLast_) return;
+
+    std::sort(iterations.begin(), iterations.end());
+    iterations.resize(iterations.size() - keepLast_);
+    for (int iteration : iterations) {
+        if (iteration == newestIteration || iteration == bestIteration) continue;
+        fs::remove(directory_ / modelFileName(iteration), ec);
+        fs::remove(directory_ / optimFileName(iteration), ec);
+    }
+}
+
+std::optional<CheckpointManager::Entry> CheckpointManager::latest() const {
+    std::ifstream manifest(directory_ / kManifestFile);
+    if (!manifest.is_open()) return std::nullopt;
+
+    Entry entry;
+    bool haveIteration = false;
+    std::string key, value;
+    while (manifest >> key >> value) {
+        if (key == "iteration") {
+            entry.iteration = std::stoi(value);
+            haveIteration = true;
+        } else if (key == "model") {
+            entry.model = directory_ / value;
+        } else if (key == "optim") {
+            entry.optim = directory_ / value;
+        } else if (key == "best") {
+            entry.best = directory_ / value;
+        }
+    }
+
+    if (!haveIteration || entry.model.empty() || !fs::exists(entry.model)) {
+        std::cerr << "[checkpoint] " << (directory_ / kManifestFile) << " names no complete checkpoint\n";
+        return std::nullopt;
+    }
+    if (!entry.optim.empty() && !fs::exists(entry.optim)) entry.optim.clear();
+    if (!entry.best.empty() && !fs::exists(entry.best)) entry.best.clear();
+    return entry;
+}
@@ -3,6 +3,7 @@
 #include "MoveGeneration.hpp"
 #include "bitboard/bitboard_utils.hpp"
 #include <algorithm>
+#include <tuple>
 
 // For counting empty squares in state.typeAtSquare.
 static inline int countEmptySquares(const std::array<uint8_t, 64> &typeAtSquare) {
@@ -14,40 +15,39 @@ static inline int countEmptySquares(const std::array<uint8_t, 64> &typeAtSquare)
     return count;
 }
 
-namespace GameStatus {
-
-    std::pair<int, bool> evaluateState(const Chess::State& state,
-                                       const std::array<bool, 4672>* valid_moves_ptr) {
-        if (valid_moves_ptr == nullptr) {
-//            std::cout << "Valid moves not provided — generating...\n";
-            std::pair<std::array<bool, 4672>, bool> result = MoveGeneration::getValidMoves(state);
-            return evaluateState(state, &result.first); // recurse
-        }
+// Squares attacked by a single king bitboard.
+static inline uint64_t kingAttacks(uint64_t king) {
+    uint64_t row = king
+                 | ((king << 1) & MoveGeneration::NO_A_FILE)
+                 | ((king >> 1) & MoveGeneration::NO_H_FILE);
+    return (row | (row << 8) | (row >> 8)) & ~king;
+}
 
-        const std::array<bool, 4672>& valid_moves = *valid_moves_ptr;
+namespace GameStatus {
 
-        // Terminal condition checks:
+    // Draws by rule, the checks that don't need the legal moves.
+    static bool drawnByRule(const Chess::State& state) {
         // 1. Repetition: if repeated_state flag's second bit is on.
         if ((state.flags.repeated_state & 0b10) != 0) {
-            return {0, true};
+            return true;
         }
         // 2. Fifty-move rule.
         if (state.flags.half_move_count >= 50) {
-            return {0, true};
+            return true;
         }
 
         // 3. Insufficient material:
         int num_empty = countEmptySquares(state.typeAtSquare);
         if (num_empty == 62) {
             // Only two kings remain.
-            return {0, true};
+            return true;
         }
         if (num_empty == 61) {
             // Only one extra piece exists – if it's a knight or bishop.
             // Check white and black knights and bishops via their bitboards.
             if ((state.pieces[bb::WHITE_BISHOP] | state.pieces[bb::BLACK_BISHOP]) ||
                 (state.pieces[bb::WHITE_KNIGHT] | state.pieces[bb::BLACK_KNIGHT])) {
-                return {0, true};
+                return true;
             }
         }
         if (num_empty == 60) {
@@ -61,17 +61,20 @@ namespace GameStatus {
                 bool wb_on_white = ((WHITE_SQUARE_MASK >> wb_index) & 1ULL) != 0;
                 bool bb_on_white = ((WHITE_SQUARE_MASK >> bb_index) & 1ULL) != 0;
                 if (wb_on_white == bb_on_white) {
-                    return {0, true};
+                    return true;
                 }
             }
         }
+        return false;
+    }
 
-        // 4. Legal move availability:
+    // 4. Legal move availability, once no draw rule applies.
+    static std::pair<int, bool> legalMoveResult(const std::array<bool, 4672>& valid_moves, bool inCheck) {
         bool hasLegalMove = std::any_of(valid_moves.begin(), valid_moves.end(),
                                         [](bool mv) { return mv; });
         if (!hasLegalMove) {
             // No legal moves: determine if it's a checkmate or stalemate.
-            if (MoveGeneration::isInCheck(state.pieces)) {
+            if (inCheck) {
                 return {1, true};  // Checkmate: White wins.
             } else {
                 return {0, true};  // Stalemate or draw.
@@ -82,4 +85,72 @@ namespace GameStatus {
         return {0, false};
     }
 
+    Analysis analyze(const Chess::State& state) {
+        Analysis analysis;
+        if (drawnByRule(state)) {
+            analysis.terminal = true;
+            return analysis;
+        }
+
+        auto [validMoves, debug] = MoveGeneration::getValidMoves(state);
+        analysis.validMoves = validMoves;
+        analysis.movesGenerated = true;
+        analysis.debug = debug;
+        analysis.inCheck = MoveGeneration::isInCheck(state.pieces);
+        std::tie(analysis.value, analysis.terminal) = legalMoveResult(analysis.validMoves, analysis.inCheck);
+        return analysis;
+    }
+
+    std::pair<int, bool> evaluateState(const Chess::State& state,
+                                       const std::array<bool, 4672>* valid_moves_ptr) {
+        if (valid_moves_ptr == nullptr) {
+            Analysis analysis = analyze(state);
+            return {analysis.value, analysis.terminal};
+        }
+
+        // Terminal condition checks:
+        if (drawnByRule(state)) {
+            return {0, true};
+        }
+        return legalMoveResult(*valid_moves_ptr, MoveGeneration::isInCheck(state.pieces));
+    }
+
+    std::pair<int, bool> adjudicateMaterial(const Chess::State& state) {
+        // Non-king material for the side to move (indices 0..4) and the side that just moved (6..10).
+        uint64_t toMove = 0ULL, justMoved = 0ULL;
+        for (int pt = bb::WHITE_PAWN; pt < bb::WHITE_KING; ++pt) toMove |= state.pieces[pt];
+        for (int pt = bb::BLACK_PAWN; pt < bb::BLACK_KING; ++pt) justMoved |= state.pieces[pt];
+
+        // Only endings against a bare king are adjudicated; bare kings are already handled.
+        if ((toMove != 0ULL) == (justMoved != 0ULL)) {
+            return {0, false};
+        }
+
+        bool toMoveIsStronger = (toMove != 0ULL);
+        uint64_t strong = toMoveIsStronger ? toMove : justMoved;
+        int offset = toMoveIsStronger ? 0 : 6;
+
+        // K+N+N cannot force mate.
+        if (bb_utils::popcount(strong) == 2 && strong == state.pieces[offset + bb::WHITE_KNIGHT]) {
+            return {0, true};
+        }
+
+        // K+Q or K+R against a bare king.
+        if (bb_utils::popcount(strong) != 1 ||
+            (strong & (state.pieces[offset + bb::WHITE_ROOK] | state.pieces[offset + bb::WHITE_QUEEN])) == 0ULL) {
+            return {0, false};
+        }
+
+        // If the bare king is to move and can take the undefended piece, the ending is not trivial.
+        if (!toMoveIsStronger) {
+            uint64_t bareKing   = state.pieces[bb::WHITE_KING];
+            uint64_t strongKing = state.pieces[bb::BLACK_KING];
+            if ((kingAttacks(bareKing) & strong) && !(kingAttacks(strongKing) & strong)) {
+                return {0, false};
+            }
+        }
+
+        return {toMoveIsStronger ? -1 : 1, true};
+    }
+
 } // namespace GameStatus
@@ -4,99 +4,528 @@
 #include "MoveGeneration.hpp"
 #include "GameStatus.hpp"
 #include "ModelInterface.hpp"
+#include "PuctKernel.hpp"
 #include <limits>
 #include <iostream>
 #include <cassert>
 #include <cmath>
+#include <algorithm>
+#include <thread>
 
 namespace MCTS {
 
+    // ------------------------------- TreeStorage / TreePool --------------------------------
+    void TreeStorage::reserve(size_t n) {
+        nodes.reserve(n);
+        if (priors.size() < n) {
+            priors.assign(n, 0.0f);
+            // Atomics can't be moved, so the arrays are rebuilt rather than resized.
+            visits = TreeVector<std::atomic<int>>(n);
+            valueSums = TreeVector<std::atomic<float>>(n);
+        }
+    }
+
+    TreeStorage TreePool::acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.empty()) {
+            created_.fetch_add(1, std::memory_order_relaxed);
+            return TreeStorage{};
+        }
+        // Most recently released first: its pages are the likeliest to still be resident.
+        TreeStorage storage = std::move(free_.back());
+        free_.pop_back();
+        reused_.fetch_add(1, std::memory_order_relaxed);
+        return storage;
+    }
+
+    void TreePool::release(TreeStorage storage) {
+        storage.nodes.clear();
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(std::move(storage));
+    }
+
+    void TreePool::prewarm(int count, size_t nodes) {
+        for (int i = 0; i < count; ++i) {
+            TreeStorage storage;
+            storage.reserve(nodes);
+            release(std::move(storage));
+        }
+    }
+
+    size_t TreePool::available() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return free_.size();
+    }
+
+    // ------------------------------------- MCTS --------------------------------------------
     // Constructor: extract parameters from args.
     // For simplicity, assume TrainerArgs has "num_searches" and "C" fields.
-    MCTS::MCTS(const AlphaZeroTrainer::TrainerArgs& args, ModelInterface& modelInterface)
+    MCTS::MCTS(const AlphaZeroTrainer::TrainerArgs& args, ModelInterface& modelInterface, TreePool* pool)
             : modelIf_(modelInterface), num_searches(args.num_searches), // or args.num_searches if defined
               C(args.C), historyLength(args.historyLength),
-              dirichlet_epsilon(args.dirichlet_epsilon), dirichlet_alpha(args.dirichlet_alpha)
+              dirichlet_epsilon(args.dirichlet_epsilon), dirichlet_alpha(args.dirichlet_alpha),
+              num_search_threads(std::max(1, args.num_search_threads)),
+              // A budget must hold the root and one expansion; pruning never goes below that.
+              maxNodes_(args.max_tree_nodes > 0 ? std::max<size_t>(args.max_tree_nodes, 2 * MAX_CHILDREN) : 0),
+              transpositions_(args.transpositions),
+              solver_(args.mcts_solver),
+              gumbel_(args.gumbel_root), gumbelConsidered_(std::max(1, args.gumbel_considered)),
+              gumbelCVisit_(static_cast<float>(args.gumbel_c_visit)), gumbelCScale_(static_cast<float>(args.gumbel_c_scale)),
+              wideningChildren_(std::max(0, args.widening_children)), wideningExponent_(args.widening_exponent),
+              pool_(pool)
     {
-        // Rough upper bound on max size of arena
-        arena.reserve(218 * (1 + num_searches));
+        if (pool_) tree_ = pool_->acquire();
+        // Upper bound on max size of arena (see maxTreeNodes), or the node budget.
+        // The tree-parallel search relies on never reallocating.
+        reserveNodes(treeCapacity(num_searches));
+    }
+
+    MCTS::~MCTS() {
+        if (pool_) pool_->release(std::move(tree_));
     }
 
-    // UCB score: if a child has zero visits, we'll use its prior value as a bonus.
-    inline float MCTS::ucbScore(const Node& child, int parentVisits) const {
-        // We use a formulation similar to: UCB = Q + C * prior * sqrt(parentVisits) / (1 + child.visit_count)
-        float Q = (1 - child.meanValue()) / 2; // What the guy in YT video did
-        return Q + static_cast<float>(C)* child.prior * std::sqrt(static_cast<float>(parentVisits)) / (1.0f + child.visit_count);
+    void MCTS::reserveNodes(size_t n) {
+        tree_.reserve(n);
+    }
+
+    size_t MCTS::treeCapacity(int simulations) const {
+        size_t worstCase = maxTreeNodes(simulations);
+        return (maxNodes_ > 0) ? std::min(worstCase, maxNodes_) : worstCase;
+    }
+
+    void MCTS::pruneTree() {
+        const int n = static_cast<int>(arena.size());
+        // Leave room for at least two expansions so small budgets don't prune after every simulation.
+        const size_t target = std::min(treeLimit_ * 3 / 4, treeLimit_ - 2 * MAX_CHILDREN);
+
+        // Subtree sizes. Children always come after their parent in the arena.
+        std::vector<int> subtree(n, 1);
+        for (int i = n - 1; i > 0; --i) subtree[arena[i].parent] += subtree[i];
+
+        // Expanded nodes below the root, least visited first. A node never has more visits than its
+        // parent and ties go to the later (deeper) index, so descendants are collapsed before ancestors.
+        std::vector<int> candidates;
+        for (int i = 1; i < n; ++i) {
+            if (arena[i].num_children > 0) candidates.push_back(i);
+        }
+        std::sort(candidates.begin(), candidates.end(), [this](int a, int b) {
+            int va = visits_[a].load(std::memory_order_relaxed), vb = visits_[b].load(std::memory_order_relaxed);
+            return (va != vb) ? va < vb : a > b;
+        });
+
+        size_t live = static_cast<size_t>(subtree[0]);
+        for (int idx : candidates) {
+            if (live <= target) break;
+            int freed = subtree[idx] - 1;
+            for (int a = idx; a != -1; a = arena[a].parent) subtree[a] -= freed;
+            live -= static_cast<size_t>(freed);
+
+            arena[idx].first_child = -1;
+            arena[idx].num_children = 0;
+            arena[idx].expansion.store(UNEXPANDED, std::memory_order_relaxed);
+        }
+
+        // New index of every surviving node: the children of collapsed nodes (and their subtrees) go.
+        std::vector<int> remap(n, -1);
+        int next = 0;
+        for (int i = 0; i < n; ++i) {
+            int parent = arena[i].parent;
+            if (parent == -1 || (remap[parent] != -1 && arena[parent].num_children > 0)) remap[i] = next++;
+        }
+
+        // Compact in place; a node only ever moves to a lower index.
+        for (int i = 0; i < n; ++i) {
+            int j = remap[i];
+            if (j == -1) continue;
+            if (j != i) {
+                arena[j] = arena[i];
+                priors_[j] = priors_[i];
+                visits_[j].store(visits_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                valueSums_[j].store(valueSums_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            Node& node = arena[j];
+            if (node.parent != -1) node.parent = remap[node.parent];
+            // Siblings survive or go together, so the child range stays contiguous.
+            if (node.num_children > 0) node.first_child = remap[node.first_child];
+        }
+        arena.erase(arena.begin() + next, arena.end());
     }
 
-    // Selection: starting at rootIdx, traverse using ucbScore until reaching a leaf (no children).
-    // Note, the map passed in is a copy of the repetition map given to us at beginning of search
-    int MCTS::selectLeaf(int rootIdx, std::unordered_map<uint64_t, uint8_t>& copyRepMap) {
+    int MCTS::appendNode(const Chess::State& state, int action, float prior, int parent, bool clearMap,
+                         StateReady stateReady) {
+        arena.emplace_back(state, action, parent, clearMap, stateReady);
+        int idx = static_cast<int>(arena.size()) - 1;
+        priors_[idx] = prior;
+        visits_[idx].store(0, std::memory_order_relaxed);
+        valueSums_[idx].store(0.0f, std::memory_order_relaxed);
+        return idx;
+    }
+
+    inline float MCTS::meanValue(int idx) const {
+        int visits = visits_[idx].load(std::memory_order_relaxed);
+        return (visits == 0) ? 0.0f : valueSums_[idx].load(std::memory_order_relaxed) / static_cast<float>(visits);
+    }
+
+    inline void MCTS::addValue(int idx, float v) {
+        float old = valueSums_[idx].load(std::memory_order_relaxed);
+        while (!valueSums_[idx].compare_exchange_weak(old, old + v, std::memory_order_relaxed)) { }
+    }
+
+    // UCB over the children: Q = (1 - mean) / 2 (what the guy in YT video did) plus
+    // C * prior * sqrt(parentVisits) / (1 + visits); see PuctKernel.hpp.
+    int MCTS::selectChild(int nodeIdx) const {
+        static_assert(sizeof(std::atomic<int>) == sizeof(int) && std::atomic<int>::is_always_lock_free,
+                      "Puct::select reads the visit counts as plain ints");
+        static_assert(sizeof(std::atomic<float>) == sizeof(float) && std::atomic<float>::is_always_lock_free,
+                      "Puct::select reads the value sums as plain floats");
+
+        const Node& node = arena[nodeIdx];
+        int first = node.first_child;
+        int parentVisits = graphSearch_ ? positionVisits(nodeIdx) : visits_[nodeIdx].load(std::memory_order_relaxed);
+        float sqrtParentVisits = std::sqrt(static_cast<float>(parentVisits));
+        int best = Puct::select(priors_.data() + first,
+                                reinterpret_cast<const int*>(visits_.data()) + first,
+                                reinterpret_cast<const float*>(valueSums_.data()) + first,
+                                selectableChildren(nodeIdx, parentVisits), static_cast<float>(C), sqrtParentVisits);
+        return (best == -1) ? -1 : first + best;
+    }
+
+    // Selection: starting at rootIdx, traverse using the UCB score until reaching a leaf (no children).
+    // Repetition counts come from the game history plus this path's hash stack (pathHashes_).
+    int MCTS::selectLeaf(int rootIdx) {
+        pathHashes_.clear();
+        path_.clear();
+        path_.push_back(rootIdx);
+        leafRepetitions_ = rootRepetitions_;
+        bool sinceRoot = true;   // no irreversible move on the path yet, the game history still counts
+
         int currIdx = rootIdx;
-        while (!arena[currIdx].children.empty()) {
+        // A solved node is a leaf: its value is known exactly.
+        while (arena[currIdx].num_children > 0 && arena[currIdx].proof.load(std::memory_order_relaxed) == UNPROVEN) {
 //            std::cout << "Printing board in selection process \n";
 //            arena[currIdx].state.validateAndPrintBoard();
 
-            int bestChildIdx = -1;
-            float bestScore = -std::numeric_limits<float>::infinity();
-            int parentVisits = arena[currIdx].visit_count;
-            for (int childIdx : arena[currIdx].children) {
-                float score = ucbScore(arena[childIdx], parentVisits);
-                if (score > bestScore) {
-                    bestScore = score;
-                    bestChildIdx = childIdx;
-                }
-            }
+            int bestChildIdx = (gumbelSearch_ && currIdx == rootIdx) ? nextGumbelRootChild() : selectChild(currIdx);
             if (bestChildIdx == -1)
                 break;
             currIdx = bestChildIdx;
+            materialize(currIdx);
+            path_.push_back(currIdx);
 
-            // If we should clear the map, do so
+            // An irreversible move: nothing before it can repeat
             if (arena[currIdx].clearMap) {
-                copyRepMap.clear();
+                pathHashes_.clear();
+                sinceRoot = false;
             }
 
             // Handle updates during selection
-            updateRepetitionTracking(arena[currIdx].state, copyRepMap);
+            pathHashes_.push_back(arena[currIdx].state.zobrist_hash);
+            leafRepetitions_ = repetitionCount(pathHashes_, sinceRoot);
+            StateTransition::updateRepeatedStateFlag(arena[currIdx].state, leafRepetitions_);
+
+            // Graph search: children linked for another repetition count are another position's. Stopping
+            // here also keeps a path from running around a cycle of shared nodes.
+            if (graphSearch_ && arena[currIdx].num_children > 0 && arena[currIdx].repetitions != leafRepetitions_)
+                break;
         }
-        // Handle update for leaf node
-        updateRepetitionTracking(arena[currIdx].state, copyRepMap);
+        // Handle update for leaf node (counted once more, as the repetition map always did)
+        pathHashes_.push_back(arena[currIdx].state.zobrist_hash);
+        StateTransition::updateRepeatedStateFlag(arena[currIdx].state, repetitionCount(pathHashes_, sinceRoot));
         return currIdx;
     }
 
-    // Expansion: Given a node at index leafIdx, expand it by generating valid actions.
-    // For simplicity, we use uniform priors for children.
-    // Return true if the node was expanded (non-terminal); false if terminal.
-    void MCTS::expandNode(int leafIdx, std::array<float, ACTION_SIZE> policy) {
+    // Expansion: Given a node at index leafIdx, expand it with one child per legal action.
+    void MCTS::expandNode(int leafIdx, const std::vector<ActionPrior>& priors) {
+
+        // Children are appended back to back
+        arena[leafIdx].first_child = static_cast<int>(arena.size());
+        arena[leafIdx].num_children += appendChildren(leafIdx, arena[leafIdx].state, priors);
 
-        // Iterate over policy
-        for (int action = 0; action < policy.size(); ++action) {
-            float action_probability = policy[action];
+        // Release: anytime queries from other threads read the root's children after this.
+        arena[leafIdx].expansion.store(EXPANDED, std::memory_order_release);
+    }
+
+    void MCTS::expandRoot(const std::vector<ActionPrior>& priors) {
+        // Gumbel search explores through its own Gumbel draws at the root.
+        if (dirichlet_epsilon <= 0.0 || gumbelSearch_) {
+            expandNode(0, priors);
+            return;
+        }
+        std::vector<ActionPrior> noisy = priors;
+        ModelInterface::addDirichletNoise(noisy, dirichlet_epsilon, dirichlet_alpha, rng_);
+        expandNode(0, noisy);
+    }
+
+    int MCTS::appendChildren(int leafIdx, const Chess::State& leafState, const std::vector<ActionPrior>& priors) {
+        // Own copy: appending may not move the arena, but the reference could be one of its nodes.
+        const Chess::State placeholder = leafState;
+
+        // Widening selects from the front, so the most promising children go first.
+        std::vector<ActionPrior> ordered;
+        const std::vector<ActionPrior>* children = &priors;
+        if (wideningChildren_ > 0) {
+            ordered = priors;
+            std::stable_sort(ordered.begin(), ordered.end(),
+                             [](const ActionPrior& a, const ActionPrior& b) { return a.prior > b.prior; });
+            children = &ordered;
+        }
+
+        int appended = 0;
+        for (const auto& [action, action_probability] : *children) {
+            // A prior that underflowed to 0 was never expanded by the dense policy either
             if (action_probability == 0) continue;
 
-            // Check if we should clear map
-            bool clearMap(false);
+            appendNode(placeholder, action, action_probability, leafIdx, false, STATE_PENDING);
+            ++appended;
+        }
+        return appended;
+    }
 
-            // Add child to arena
-            arena.emplace_back(StateTransition::getCopyNextState(arena[leafIdx].state, action, clearMap), action, action_probability, leafIdx, clearMap);
+    void MCTS::materialize(int childIdx) {
+        Node& child = arena[childIdx];
+        if (child.stateReady.load(std::memory_order_acquire) == STATE_READY) return;
 
-            // Add child index to children
-            arena[leafIdx].children.emplace_back(static_cast<int>(arena.size()) - 1);
+        uint8_t expected = STATE_PENDING;
+        if (child.stateReady.compare_exchange_strong(expected, STATE_BUILDING, std::memory_order_acq_rel)) {
+            // Check if we should clear map
+            bool clearMap(false);
+            child.state = StateTransition::getCopyNextState(arena[child.parent].state, child.action_taken, clearMap);
+            child.clearMap = clearMap;
+            child.stateReady.store(STATE_READY, std::memory_order_release);
+            return;
         }
+        while (child.stateReady.load(std::memory_order_acquire) != STATE_READY) std::this_thread::yield();
+    }
+
+    int MCTS::selectableChildren(int nodeIdx, int parentVisits) const {
+        int children = arena[nodeIdx].num_children;
+        if (wideningChildren_ <= 0) return children;
+        int window = wideningChildren_ + static_cast<int>(std::pow(static_cast<double>(parentVisits), wideningExponent_));
+        return std::min(children, window);
     }
 
     // Backpropagation: from nodeIdx, update ancestors with simulation value.
     void MCTS::backpropagate(int nodeIdx, float value) {
         int currIdx = nodeIdx;
         while (currIdx != -1) {
-            arena[currIdx].visit_count += 1;
-            arena[currIdx].value_sum += value;
+            visits_[currIdx].fetch_add(1, std::memory_order_relaxed);
+            addValue(currIdx, value);
             // Flip the value for the opponent.
             value = -value;
             currIdx = arena[currIdx].parent;
         }
     }
 
+    void MCTS::backupLeaf(int leafIdx, float value) {
+        if (graphSearch_) backpropagatePath(path_, value, 0);
+        else backpropagate(leafIdx, value);
+    }
+
+    Proof MCTS::proofFromChildren(int nodeIdx) const {
+        const Node& node = arena[nodeIdx];
+        if (node.num_children == 0) return UNPROVEN;
+
+        bool allProven = true, anyDraw = false;
+        for (int c = node.first_child; c < node.first_child + node.num_children; ++c) {
+            uint8_t proof = arena[c].proof.load(std::memory_order_relaxed);
+            if (proof == PROVEN_LOSS) return PROVEN_WIN;
+            if (proof == UNPROVEN) allProven = false;
+            else if (proof == PROVEN_DRAW) anyDraw = true;
+        }
+        if (!allProven) return UNPROVEN;
+        return anyDraw ? PROVEN_DRAW : PROVEN_LOSS;
+    }
+
+    void MCTS::propagateProof(int leafIdx, Proof proof) {
+        arena[leafIdx].proof.store(proof, std::memory_order_relaxed);
+        for (int idx = arena[leafIdx].parent; idx != -1; idx = arena[idx].parent) {
+            if (arena[idx].proof.load(std::memory_order_relaxed) != UNPROVEN) break;
+            Proof parentProof = proofFromChildren(idx);
+            if (parentProof == UNPROVEN) break;
+            arena[idx].proof.store(parentProof, std::memory_order_relaxed);
+        }
+    }
+
+    bool MCTS::achievesRootProof(int childIdx) const {
+        // Children are proven for the opponent.
+        switch (arena[0].proof.load(std::memory_order_relaxed)) {
+            case PROVEN_WIN:  return arena[childIdx].proof.load(std::memory_order_relaxed) == PROVEN_LOSS;
+            case PROVEN_DRAW: return arena[childIdx].proof.load(std::memory_order_relaxed) == PROVEN_DRAW;
+            default:          return true;
+        }
+    }
+
+    void MCTS::beginGumbelRoot(float rootValue) {
+        const Node& root = arena[0];
+
+        // Gumbel(0, 1) is the standard extreme value distribution.
+        std::extreme_value_distribution<float> gumbel(0.0f, 1.0f);
+        std::vector<float> noise(root.num_children);
+        std::vector<float> perturbed(root.num_children);
+        for (int i = 0; i < root.num_children; ++i) {
+            noise[i] = gumbel(rng_);
+            perturbed[i] = noise[i] + std::log(std::max(priors_[root.first_child + i], 1e-12f));
+        }
+
+        // Gumbel-top-k: the k largest gumbel + logit are k actions sampled from the prior without replacement.
+        std::vector<int> considered(root.num_children);
+        for (int i = 0; i < root.num_children; ++i) considered[i] = root.first_child + i;
+        std::sort(considered.begin(), considered.end(), [&](int a, int b) {
+            return perturbed[a - root.first_child] > perturbed[b - root.first_child];
+        });
+        considered.resize(std::min<size_t>(considered.size(), gumbelConsidered_));
+
+        std::lock_guard<std::mutex> lock(gumbelMutex_);
+        rootNetworkValue_ = rootValue;
+        rootGumbel_ = std::move(noise);
+        considered_ = std::move(considered);
+        gumbelPhases_ = std::max(1, static_cast<int>(std::ceil(std::log2(static_cast<double>(considered_.size())))));
+        gumbelTarget_ = 0;
+        gumbelCursor_ = 0;
+    }
+
+    int MCTS::nextGumbelRootChild() {
+        if (considered_.empty()) return -1;
+        while (true) {
+            for (size_t i = 0; i < considered_.size(); ++i) {
+                size_t slot = (gumbelCursor_ + i) % considered_.size();
+                int child = considered_[slot];
+                if (visits_[child].load(std::memory_order_relaxed) < gumbelTarget_) {
+                    gumbelCursor_ = slot + 1;
+                    return child;
+                }
+            }
+
+            // Phase done: keep the better half, then give each survivor its share of the budget.
+            if (gumbelTarget_ > 0 && considered_.size() > 1) {
+                int maxVisits = maxRootVisits();
+                std::vector<int> ranked = considered_;
+                std::stable_sort(ranked.begin(), ranked.end(), [this, maxVisits](int a, int b) {
+                    return gumbelScore(a, maxVisits) > gumbelScore(b, maxVisits);
+                });
+                ranked.resize((ranked.size() + 1) / 2);
+                std::lock_guard<std::mutex> lock(gumbelMutex_);
+                considered_ = std::move(ranked);
+            }
+            int share = nodeBudget_ / (gumbelPhases_ * static_cast<int>(considered_.size()));
+            gumbelTarget_ += std::max(1, share);
+            gumbelCursor_ = 0;
+        }
+    }
+
+    float MCTS::gumbelSigma(float q, int maxVisits) const {
+        // Values are normalized to [0, 1] first.
+        return (gumbelCVisit_ + static_cast<float>(maxVisits)) * gumbelCScale_ * 0.5f * (q + 1.0f);
+    }
+
+    float MCTS::gumbelScore(int childIdx, int maxVisits) const {
+        int offset = childIdx - arena[0].first_child;
+        float logit = std::log(std::max(priors_[childIdx], 1e-12f));
+        bool visited = visits_[childIdx].load(std::memory_order_relaxed) > 0;
+        // Child values are for the opponent.
+        float q = visited ? -meanValue(childIdx) : 0.0f;
+        return rootGumbel_[offset] + logit + (visited ? gumbelSigma(q, maxVisits) : 0.0f);
+    }
+
+    int MCTS::maxRootVisits() const {
+        const Node& root = arena[0];
+        int maxVisits = 0;
+        for (int c = root.first_child; c < root.first_child + root.num_children; ++c) {
+            maxVisits = std::max(maxVisits, visits_[c].load(std::memory_order_relaxed));
+        }
+        return maxVisits;
+    }
+
+    std::array<float, ACTION_SIZE> MCTS::gumbelPolicy() const {
+        std::array<float, ACTION_SIZE> policy{};
+        const Node& root = arena[0];
+        if (root.num_children == 0) return policy;
+
+        // Mixed value for the unvisited children: the network value, blended with the prior-weighted Q
+        // of the visited ones in proportion to their visits.
+        int totalVisits = 0;
+        float visitedPrior = 0.0f, weightedQ = 0.0f;
+        for (int c = root.first_child; c < root.first_child + root.num_children; ++c) {
+            int visits = visits_[c].load(std::memory_order_relaxed);
+            if (visits == 0) continue;
+            totalVisits += visits;
+            visitedPrior += priors_[c];
+            weightedQ += priors_[c] * -meanValue(c);
+        }
+        float networkValue;
+        {
+            std::lock_guard<std::mutex> lock(gumbelMutex_);
+            networkValue = rootNetworkValue_;
+        }
+        float mixedValue = networkValue;
+        if (totalVisits > 0 && visitedPrior > 0.0f) {
+            mixedValue = (networkValue + static_cast<float>(totalVisits) * weightedQ / visitedPrior)
+                         / static_cast<float>(1 + totalVisits);
+        }
+
+        int maxVisits = maxRootVisits();
+        std::vector<float> logits(root.num_children);
+        float maxLogit = -std::numeric_limits<float>::infinity();
+        for (int i = 0; i < root.num_children; ++i) {
+            int c = root.first_child + i;
+            float completedQ = (visits_[c].load(std::memory_order_relaxed) > 0) ? -meanValue(c) : mixedValue;
+            logits[i] = std::log(std::max(priors_[c], 1e-12f)) + gumbelSigma(completedQ, maxVisits);
+            maxLogit = std::max(maxLogit, logits[i]);
+        }
+        float sum = 0.0f;
+        for (float& l : logits) {
+            l = std::exp(l - maxLogit);
+            sum += l;
+        }
+        for (int i = 0; i < root.num_children; ++i) {
+            policy[arena[root.first_child + i].action_taken] = logits[i] / sum;
+        }
+        return policy;
+    }
+
+    uint64_t MCTS::transpositionKey(const Chess::State& state, uint8_t repetitions) {
+        // Zobrist hashes don't cover the repetition count or the fifty-move clock, which both change the
+        // value of a position (and the network input).
+        uint64_t discriminator = (static_cast<uint64_t>(repetitions) << 8) | state.flags.half_move_count;
+        return state.zobrist_hash ^ (discriminator * 0x9E3779B97F4A7C15ULL);
+    }
+
+    int MCTS::positionVisits(int nodeIdx) const {
+        const Node& node = arena[nodeIdx];
+        int visits = 1;
+        for (int c = node.first_child; c < node.first_child + node.num_children; ++c) {
+            visits += visits_[c].load(std::memory_order_relaxed);
+        }
+        return visits;
+    }
+
+    float MCTS::positionValue(const Transposition& position) const {
+        // Child edge values are for the opponent.
+        float sum = position.value;
+        int visits = 1;
+        for (int c = position.first_child; c < position.first_child + position.num_children; ++c) {
+            visits += visits_[c].load(std::memory_order_relaxed);
+            sum -= valueSums_[c].load(std::memory_order_relaxed);
+        }
+        return sum / static_cast<float>(visits);
+    }
+
+    bool MCTS::linkTransposition(int leafIdx) {
+        auto it = transpositionTable_.find(transpositionKey(arena[leafIdx].state, leafRepetitions_));
+        if (it == transpositionTable_.end()) return false;
+
+        Node& leaf = arena[leafIdx];
+        leaf.first_child = it->second.first_child;
+        leaf.num_children = it->second.num_children;
+        leaf.repetitions = leafRepetitions_;
+        leaf.expansion.store(EXPANDED, std::memory_order_release);
+
+        backpropagatePath(path_, positionValue(it->second), 0);
+        simulationsDone_.fetch_add(1, std::memory_order_relaxed);
+        ++transpositionHits_;
+        return true;
+    }
+
     // Build a vector of the previous historyLength states (including current)
     std::vector<Chess::State> MCTS::getCurrentTStates(int nodeIdx) {
         std::vector<Chess::State> result;
@@ -118,10 +547,15 @@ namespace MCTS {
         return result;
     }
 
-    void MCTS::updateRepetitionTracking(Chess::State& state, std::unordered_map<uint64_t, uint8_t>& repMap) {
-        uint64_t hash = state.zobrist_hash;
-        uint8_t count = ++repMap[hash];  // increment and capture count
-        StateTransition::updateRepeatedStateFlag(state, count);
+    uint8_t MCTS::repetitionCount(const std::vector<uint64_t>& pathHashes, bool sinceRoot) const {
+        // Occurrences of the newest position; both stacks only reach back to the last irreversible move.
+        uint64_t hash = pathHashes.back();
+        uint8_t count = 0;
+        for (uint64_t h : pathHashes) count += (h == hash);
+        if (sinceRoot) {
+            for (uint64_t h : rootHistory_) count += (h == hash);
+        }
+        return count;
     }
 
     // Debug
@@ -130,6 +564,8 @@ namespace MCTS {
         while (currIdx != -1) {
 
             arena[currIdx].print(currIdx);
+            std::cout << "  prior " << priors_[currIdx] << ", visits " << visits_[currIdx].load()
+                      << ", value_sum " << valueSums_[currIdx].load() << ", mean " << meanValue(currIdx) << "\n";
 
             currIdx = arena[currIdx].parent;
         }
@@ -140,93 +576,383 @@ namespace MCTS {
     // Returns a vector of normalized visit counts for each possible action (of length equal to the action size).
     std::array<float, ACTION_SIZE> MCTS::search(const Chess::State& rootState,
                                     const std::unordered_map<uint64_t, uint8_t>& repetitionMap) {
+        return search(rootState, repetitionMap, SearchLimits{});
+    }
+
+    std::array<float, ACTION_SIZE> MCTS::search(const Chess::State& rootState,
+                                    const std::unordered_map<uint64_t, uint8_t>& repetitionMap,
+                                    const SearchLimits& limits) {
+        beginSearch(rootState, repetitionMap, limits);
+
+        if (num_search_threads > 1) {
+            // The root is evaluated once up front, then the workers share the tree.
+            graphSearch_ = false;
+            solving_ = false;
+            gumbelSearch_ = false;
+            auto [priorsRoot, _] = modelIf_.evaluateLegal(pendingStates_, pendingLegalActions_);
+            expandRoot(priorsRoot);
+            searchParallel();
+            return searchResult();
+        }
+
+        // Evaluate synchronously whatever the search is waiting on.
+        while (awaitingEvaluation()) {
+            auto [priors, value] = modelIf_.evaluateLegal(pendingStates_, pendingLegalActions_);
+            provideEvaluation(priors, value);
+        }
+
+        return searchResult();
+    }
+
+    void MCTS::beginSearch(const Chess::State& rootState,
+                           const std::unordered_map<uint64_t, uint8_t>& repetitionMap,
+                           const SearchLimits& limits) {
+        beginSearch(rootState, repetitionMap, GameStatus::analyze(rootState), limits);
+    }
+
+    void MCTS::beginSearch(const Chess::State& rootState,
+                           const std::unordered_map<uint64_t, uint8_t>& repetitionMap,
+                           const GameStatus::Analysis& rootAnalysis,
+                           const SearchLimits& limits) {
+
+        // Budget for this search
+        limits_ = limits;
+        nodeBudget_ = (limits.max_nodes > 0) ? limits.max_nodes : num_searches;
+        searchStart_ = std::chrono::steady_clock::now();
+        stopRequested_.store(false, std::memory_order_relaxed);
+        simulationsDone_.store(0, std::memory_order_relaxed);
+
         // Clear the arena.
         arena.clear();
 
+        // Make sure the arena never reallocates mid-search (see the constructor)
+        treeLimit_ = treeCapacity(nodeBudget_);
+        if (tree_.capacity() < treeLimit_) reserveNodes(treeLimit_);
+
         // Create the root node; parent index = -1, action_taken = -1.
-        Node root(rootState, -1, 1.0f, -1, false);
-        root.visit_count = 1; // Set initial visit count.
-        arena.push_back(root);
+        appendNode(rootState, -1, 1.0f, -1, false);
+        visits_[0].store(1, std::memory_order_relaxed); // Set initial visit count.
 
-        // Get initial states
-        std::vector<Chess::State> rootStates;
-        rootStates.reserve(historyLength);
+        // Keep our own copy, the game may move on while we're suspended. Flattened to one hash per
+        // occurrence: selection counts repetitions by scanning it, no map copy per simulation.
+        rootHistory_.clear();
+        for (const auto& [hash, count] : repetitionMap) rootHistory_.insert(rootHistory_.end(), count, hash);
 
-        for (int t = 0; t < historyLength; ++t) {
-            rootStates.emplace_back(arena[0].state);
+        // Graph search starts from an empty table
+        graphSearch_ = transpositions_;
+        solving_ = solver_ && !graphSearch_;
+        gumbelSearch_ = gumbel_;
+        {
+            std::lock_guard<std::mutex> lock(gumbelMutex_);
+            considered_.clear();
         }
+        transpositionTable_.clear();
+        transpositionHits_ = 0;
+        auto rootCount = std::count(rootHistory_.begin(), rootHistory_.end(), arena[0].state.zobrist_hash);
+        rootRepetitions_ = static_cast<uint8_t>(std::max<long>(1, rootCount));
 
-        // Get policy for root
-        auto [rawPolicyRoot, _] = modelIf_.evaluateWithNetwork(rootStates);
+        // Get initial states
+        pendingStates_.assign(historyLength, arena[0].state);
+        // Root's legal moves, from the caller's analysis (a position drawn by rule has none generated,
+        // but can still be searched)
+        pendingLegalActions_ = MoveGeneration::getLegalActions(rootAnalysis.movesGenerated
+                                                               ? rootAnalysis.validMoves
+                                                               : MoveGeneration::getValidMoves(rootState).first);
+        pendingLeaf_ = 0;
+        phase_ = SearchPhase::AwaitingRoot;
+    }
 
-        // Add DirichletNoise to root only
-        auto noiseAddedPolicyRoot = modelIf_.addDirichletNoise(rawPolicyRoot, dirichlet_epsilon, dirichlet_alpha);
+    void MCTS::provideEvaluation(const std::vector<ActionPrior>& priors, float value) {
+        if (phase_ == SearchPhase::AwaitingRoot) {
+            // Expand root
+            expandRoot(priors);
+            if (graphSearch_) {
+                transpositionTable_[transpositionKey(arena[0].state, rootRepetitions_)] =
+                        Transposition{arena[0].first_child, arena[0].num_children, value};
+            }
+            if (gumbelSearch_) beginGumbelRoot(value);
+        }
+        else if (phase_ == SearchPhase::AwaitingLeaf) {
+            if (graphSearch_) {
+                // A node stopped at for a repetition mismatch gets children of its own.
+                arena[pendingLeaf_].first_child = -1;
+                arena[pendingLeaf_].num_children = 0;
+            }
 
-        // Get root's valid moves
-        auto [validMovesRoot, b] = MoveGeneration::getValidMoves(arena[0].state);
+            // Expand node
+            expandNode(pendingLeaf_, priors);
 
-        // Masked policy for root
-        auto policyRoot = modelIf_.maskAndNormalizePolicy(rawPolicyRoot, validMovesRoot);
+            if (graphSearch_) {
+                Node& leaf = arena[pendingLeaf_];
+                leaf.repetitions = leafRepetitions_;
+                transpositionTable_[transpositionKey(leaf.state, leafRepetitions_)] =
+                        Transposition{leaf.first_child, leaf.num_children, value};
+            }
 
-//        /// Debugging
-//        std::cout << "Printing ROOT board \n";
-//        rootState.validateAndPrintBoard();
+            // Backpropagation: update the tree along the selected path.
+            backupLeaf(pendingLeaf_, value);
+            simulationsDone_.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            return;
+        }
 
-        // Expand root
-        expandNode(0, policyRoot);
+        runSimulations();
+    }
 
+    void MCTS::runSimulations() {
         // Perform MCTS iterations.
-        for (int iter = 0; iter < num_searches; ++iter) {
+        while (!budgetExhausted()) {
 
-//            if (iter % 100 == 0) std::cout << "I'm on move: " << iter << " of mcts search\n";
-            // Create a copy of repetition map for this search through tree
-            auto copyRepMap = repetitionMap;
+            // Bounded tree: make room for the next expansion, or end the search if pruning can't.
+            if (maxNodes_ > 0 && arena.size() + MAX_CHILDREN > treeLimit_) {
+                // Shared child ranges aren't subtrees; a full graph just ends the search.
+                if (!graphSearch_) pruneTree();
+                if (arena.size() + MAX_CHILDREN > treeLimit_) break;
+            }
 
             // Selection: starting at root, select a leaf.
-            int leafIdx = selectLeaf(0, copyRepMap);
-//
-//            arena[leafIdx].state.validateAndPrintBoard();
-//            bool checkQueen = (arena[leafIdx].state.flags.turn == 0 && (arena[leafIdx].state.typeAtSquare[32] == 4 || arena[leafIdx].state.typeAtSquare[41] == 4)) || (arena[leafIdx].state.flags.turn == 1 && (arena[leafIdx].state.typeAtSquare[39] == 4 || arena[leafIdx].state.typeAtSquare[46] == 4));
-//
+            int leafIdx = selectLeaf(0);
 
-            // Calculate valid moves here
-            auto [validMovesLeaf, debug] = MoveGeneration::getValidMoves(arena[leafIdx].state);
+            // A solved node backs up its exact value; nothing below it is searched again.
+            uint8_t proof = arena[leafIdx].proof.load(std::memory_order_relaxed);
+            if (proof != UNPROVEN) {
+                backupLeaf(leafIdx, proof == PROVEN_WIN ? 1.0f : proof == PROVEN_LOSS ? -1.0f : 0.0f);
+                simulationsDone_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
 
-            if (debug) mctsDebugger(leafIdx);
+            // Evaluate the state; moves are only generated if no draw rule ends the game here
+            GameStatus::Analysis analysis = GameStatus::analyze(arena[leafIdx].state);
 
-            // Evaluate the state
-            auto [intVal, isTerminal] = GameStatus::evaluateState(arena[leafIdx].state, &validMovesLeaf);
-            auto value = static_cast<float>(-intVal);
+            if (analysis.debug) mctsDebugger(leafIdx);
 
-            if (!isTerminal) {
-                // Get current T states from leaf (including itself)
-                auto currentStates = getCurrentTStates(leafIdx);
+            const int intVal = analysis.value;
+            if (!analysis.terminal) {
+                // A position the graph already knows needs no evaluation.
+                if (graphSearch_ && linkTransposition(leafIdx)) continue;
 
-                // Get policy for root
-                auto [rawPolicyLeaf, modelValue] = modelIf_.evaluateWithNetwork(currentStates);
+                // Suspend until the network has evaluated the last T states from the leaf.
+                pendingLeaf_ = leafIdx;
+                pendingLegalActions_ = MoveGeneration::getLegalActions(analysis.validMoves);
+                pendingStates_ = graphSearch_ ? getPathTStates(path_, {}) : getCurrentTStates(leafIdx);
+                phase_ = SearchPhase::AwaitingLeaf;
+                return;
+            }
 
-                // Masked policy for root
-                auto policyLeaf = modelIf_.maskAndNormalizePolicy(rawPolicyLeaf, validMovesLeaf);
+            // Values are for the side that just moved, i.e. +1 means the side to move here is mated.
+            if (solving_) propagateProof(leafIdx, intVal > 0 ? PROVEN_LOSS : intVal < 0 ? PROVEN_WIN : PROVEN_DRAW);
 
-                // Set value to modelValue
-                value = modelValue;
+            // Backpropagation: update the tree along the selected path.
+            backupLeaf(leafIdx, static_cast<float>(-intVal));
+            simulationsDone_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        pendingLeaf_ = -1;
+        pendingStates_.clear();
+        pendingLegalActions_.clear();
+        phase_ = SearchPhase::Done;
+    }
+
+    // ---------------------------- Tree-parallel search ----------------------------
 
-                // Expand node
-                expandNode(leafIdx, policyLeaf);
+    void MCTS::searchParallel() {
+        std::atomic<int> nextSimulation{0};
+
+        auto worker = [this, &nextSimulation]() {
+            std::vector<int> path;
+            std::vector<uint8_t> pathCounts;
+            std::vector<uint64_t> pathHashes;
+            path.reserve(64);
+            pathCounts.reserve(64);
+            pathHashes.reserve(64);
+            while (!budgetExhausted() &&
+                   nextSimulation.fetch_add(1, std::memory_order_relaxed) < nodeBudget_) {
+                parallelSimulation(path, pathCounts, pathHashes);
+                simulationsDone_.fetch_add(1, std::memory_order_relaxed);
             }
+        };
 
-            // Backpropagation: update the tree along the selected path.
-            backpropagate(leafIdx, value);
+        // A root without legal moves has nothing to search.
+        if (arena[0].num_children > 0) {
+            std::vector<std::thread> workers;
+            workers.reserve(num_search_threads - 1);
+            for (int t = 1; t < num_search_threads; ++t) {
+                workers.emplace_back(worker);
+            }
+            worker();
+            for (auto& w : workers) w.join();
         }
 
+        pendingLeaf_ = -1;
+        pendingStates_.clear();
+        pendingLegalActions_.clear();
+        phase_ = SearchPhase::Done;
+    }
+
+    void MCTS::parallelSimulation(std::vector<int>& path, std::vector<uint8_t>& pathCounts,
+                                  std::vector<uint64_t>& pathHashes) {
+        while (true) {
+            path.clear();
+            pathCounts.clear();
+
+            // Same repetition bookkeeping as selectLeaf, but the flags stay local to this descent.
+            pathHashes.clear();
+            bool sinceRoot = true;
+
+            int currIdx = 0;
+            path.push_back(0);
+            pathCounts.push_back(0);
+
+            // Selection: only descend through nodes whose children are published.
+            while (arena[currIdx].expansion.load(std::memory_order_acquire) == EXPANDED &&
+                   arena[currIdx].num_children > 0) {
+                currIdx = selectChild(currIdx);
+                materialize(currIdx);
+
+                // Virtual loss: looks visited and good for the side to move there, i.e. bad for the chooser.
+                visits_[currIdx].fetch_add(VIRTUAL_LOSS, std::memory_order_relaxed);
+                addValue(currIdx, static_cast<float>(VIRTUAL_LOSS));
+                path.push_back(currIdx);
+
+                if (arena[currIdx].clearMap) {
+                    pathHashes.clear();
+                    sinceRoot = false;
+                }
+                pathHashes.push_back(arena[currIdx].state.zobrist_hash);
+                pathCounts.push_back(repetitionCount(pathHashes, sinceRoot));
+            }
+            // Update for leaf node, as selectLeaf does
+            pathHashes.push_back(arena[currIdx].state.zobrist_hash);
+            pathCounts.back() = repetitionCount(pathHashes, sinceRoot);
+
+            Node& leaf = arena[currIdx];
+
+            // Terminal leaves cache their value, no need to claim them.
+            uint8_t expansion = leaf.expansion.load(std::memory_order_acquire);
+            if (expansion == TERMINAL) {
+                backpropagatePath(path, leaf.terminal_value);
+                return;
+            }
+
+            // Claim the leaf. If another worker is already on it, back off and descend again.
+            uint8_t expected = UNEXPANDED;
+            if (expansion != UNEXPANDED ||
+                !leaf.expansion.compare_exchange_strong(expected, EXPANDING, std::memory_order_acq_rel)) {
+                revertVirtualLoss(path);
+                std::this_thread::yield();
+                continue;
+            }
+
+            // The leaf's state with this descent's repetition flag
+            Chess::State leafState = leaf.state;
+            StateTransition::updateRepeatedStateFlag(leafState, pathCounts.back());
+
+            // Evaluate the state; moves are only generated if no draw rule ends the game here
+            GameStatus::Analysis analysis = GameStatus::analyze(leafState);
+
+            if (analysis.debug) mctsDebugger(currIdx);
+
+            if (analysis.terminal) {
+                leaf.terminal_value = static_cast<float>(-analysis.value);
+                leaf.expansion.store(TERMINAL, std::memory_order_release);
+                backpropagatePath(path, leaf.terminal_value);
+                return;
+            }
+
+            auto currentStates = getPathTStates(path, pathCounts);
+            auto [priorsLeaf, modelValue] = modelIf_.evaluateLegal(currentStates,
+                                                                   MoveGeneration::getLegalActions(analysis.validMoves));
+
+            expandNodeConcurrent(currIdx, leafState, priorsLeaf);
+            backpropagatePath(path, modelValue);
+            return;
+        }
+    }
+
+    void MCTS::expandNodeConcurrent(int leafIdx, const Chess::State& leafState,
+                                    const std::vector<ActionPrior>& priors) {
+        int firstChild, numChildren;
+        {
+            std::lock_guard<std::mutex> lock(arenaMutex_);
+            // Workers hold indices into the tree, so it can't be pruned under them: once the node
+            // budget is spent the leaf stays unexpanded (its value is still backed up) and the search ends.
+            // Children are counted before anything is appended; the check is on the upper bound.
+            if (maxNodes_ > 0 && arena.size() + priors.size() > treeLimit_) {
+                arena[leafIdx].expansion.store(UNEXPANDED, std::memory_order_release);
+                stop();
+                return;
+            }
+            // Growing past the reservation would move nodes other workers are reading.
+            assert(arena.size() + priors.size() <= tree_.capacity());
+            firstChild = static_cast<int>(arena.size());
+            // Placeholders are cheap; the next states are computed as selection reaches them.
+            numChildren = appendChildren(leafIdx, leafState, priors);
+        }
+
+        // Only the claiming worker touches the child range until the release below publishes it.
+        arena[leafIdx].first_child = firstChild;
+        arena[leafIdx].num_children = numChildren;
+        arena[leafIdx].expansion.store(EXPANDED, std::memory_order_release);
+    }
+
+    void MCTS::backpropagatePath(const std::vector<int>& path, float value, int virtualLoss) {
+        for (int i = static_cast<int>(path.size()) - 1; i >= 0; --i) {
+            // Every node but the root carries this simulation's virtual loss.
+            int vl = (i > 0) ? virtualLoss : 0;
+            visits_[path[i]].fetch_add(1 - vl, std::memory_order_relaxed);
+            addValue(path[i], value - static_cast<float>(vl));
+            // Flip the value for the opponent.
+            value = -value;
+        }
+    }
+
+    void MCTS::revertVirtualLoss(const std::vector<int>& path) {
+        for (size_t i = 1; i < path.size(); ++i) {
+            visits_[path[i]].fetch_sub(VIRTUAL_LOSS, std::memory_order_relaxed);
+            addValue(path[i], -static_cast<float>(VIRTUAL_LOSS));
+        }
+    }
+
+    std::vector<Chess::State> MCTS::getPathTStates(const std::vector<int>& path,
+                                                   const std::vector<uint8_t>& pathCounts) const {
+        std::vector<Chess::State> result;
+        result.reserve(historyLength);
+
+        // Walk the path from the leaf back towards the root.
+        for (int i = static_cast<int>(path.size()) - 1; i >= 0 && static_cast<int>(result.size()) < historyLength; --i) {
+            result.push_back(arena[path[i]].state);
+            if (!pathCounts.empty() && pathCounts[i] != 0) {
+                StateTransition::updateRepeatedStateFlag(result.back(), pathCounts[i]);
+            }
+        }
+
+        // If fewer than historyLength were found, pad with copies of the oldest state
+        while (static_cast<int>(result.size()) < historyLength && !result.empty()) {
+            result.push_back(result.back());
+        }
+
+        // Reverse to get states from oldest to newest (chronological order)
+        std::reverse(result.begin(), result.end());
+
+        return result;
+    }
+
+    std::array<float, ACTION_SIZE> MCTS::searchResult() const {
         // Create and return action probabilities
         std::array<float, ACTION_SIZE> action_probs{};
+        if (arena.empty() || arena[0].expansion.load(std::memory_order_acquire) != EXPANDED) return action_probs;
+
+        // Gumbel: the improved policy, unless the solver already knows the answer
+        if (gumbelSearch_ && arena[0].proof.load(std::memory_order_relaxed) == UNPROVEN) return gumbelPolicy();
+
         float sum = 0.0f;
 
-        for (int childIdx : arena[0].children) {
-            const auto& child = arena[childIdx];
-            auto visits = static_cast<float>(child.visit_count);
-            action_probs[child.action_taken] = visits;
+        const Node& root = arena[0];
+        for (int childIdx = root.first_child; childIdx < root.first_child + root.num_children; ++childIdx) {
+            if (!achievesRootProof(childIdx)) continue;
+            auto visits = static_cast<float>(visits_[childIdx].load(std::memory_order_relaxed));
+            action_probs[arena[childIdx].action_taken] = visits;
             sum += visits;
         }
 
@@ -240,4 +966,94 @@ namespace MCTS {
         return action_probs;
     }
 
+    bool MCTS::budgetExhausted() const {
+        if (stopRequested_.load(std::memory_order_relaxed)) return true;
+
+        // Nothing left to find out
+        if (arena[0].proof.load(std::memory_order_relaxed) != UNPROVEN) return true;
+
+        int done = simulationsDone_.load(std::memory_order_relaxed);
+        if (done >= nodeBudget_) return true;
+
+        if (limits_.max_time_ms <= 0.0 && !limits_.early_stop) return false;
+
+        double elapsedMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - searchStart_).count();
+        if (limits_.max_time_ms > 0.0 && elapsedMs >= limits_.max_time_ms) return true;
+
+        if (!limits_.early_stop) return false;
+
+        // Simulations the budget still allows; under a clock, extrapolate the current rate.
+        int remaining = nodeBudget_ - done;
+        if (limits_.max_time_ms > 0.0 && done > 0) {
+            double rate = static_cast<double>(done) / elapsedMs;
+            remaining = std::min(remaining, static_cast<int>(rate * (limits_.max_time_ms - elapsedMs)));
+        }
+
+        // Even if every remaining simulation went to the runner-up, it couldn't catch up.
+        int bestVisits, secondVisits, bestAction;
+        topRootChildren(bestVisits, secondVisits, bestAction);
+        return bestAction != -1 && bestVisits - secondVisits > remaining;
+    }
+
+    void MCTS::topRootChildren(int& bestVisits, int& secondVisits, int& bestAction) const {
+        bestVisits = 0;
+        secondVisits = 0;
+        bestAction = -1;
+        if (arena.empty() || arena[0].expansion.load(std::memory_order_acquire) != EXPANDED) return;
+
+        const Node& root = arena[0];
+        for (int childIdx = root.first_child; childIdx < root.first_child + root.num_children; ++childIdx) {
+            if (!achievesRootProof(childIdx)) continue;
+            int visits = visits_[childIdx].load(std::memory_order_relaxed);
+            if (bestAction == -1 || visits > bestVisits) {
+                secondVisits = bestVisits;
+                bestVisits = visits;
+                bestAction = arena[childIdx].action_taken;
+            } else if (visits > secondVisits) {
+                secondVisits = visits;
+            }
+        }
+    }
+
+    int MCTS::bestAction() const {
+        if (gumbelSearch_ && !arena.empty() && arena[0].proof.load(std::memory_order_relaxed) == UNPROVEN) {
+            std::lock_guard<std::mutex> lock(gumbelMutex_);
+            if (!considered_.empty()) {
+                int maxVisits = maxRootVisits();
+                int best = *std::max_element(considered_.begin(), considered_.end(), [this, maxVisits](int a, int b) {
+                    return gumbelScore(a, maxVisits) < gumbelScore(b, maxVisits);
+                });
+                return arena[best].action_taken;
+            }
+        }
+        int bestVisits, secondVisits, action;
+        topRootChildren(bestVisits, secondVisits, action);
+        return action;
+    }
+
+    float MCTS::rootValue() const {
+        if (arena.empty()) return 0.0f;
+
+        switch (arena[0].proof.load(std::memory_order_relaxed)) {
+            case PROVEN_WIN:  return 1.0f;
+            case PROVEN_DRAW: return 0.0f;
+            case PROVEN_LOSS: return -1.0f;
+            default:          break;
+        }
+
+        int bestIdx = -1;
+        int bestVisits = -1;
+        const Node& root = arena[0];
+        for (int childIdx = root.first_child; childIdx < root.first_child + root.num_children; ++childIdx) {
+            int visits = visits_[childIdx].load(std::memory_order_relaxed);
+            if (visits > bestVisits) {
+                bestVisits = visits;
+                bestIdx = childIdx;
+            }
+        }
+        // Child values are stored from the opponent's perspective, so flip the sign.
+        return (bestIdx == -1) ? meanValue(0) : -meanValue(bestIdx);
+    }
+
 } // namespace MCTS
\ No newline at end of file
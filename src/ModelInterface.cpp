@@ -1,9 +1,26 @@
 // src/ModelInterface.cpp
 #include "ModelInterface.hpp"
 #include <torch/serialize.h>  // for OutputArchive
-#include <filesystem> // Add this at the top
 #include <cassert>
-namespace fs = std::filesystem;
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+#include <iostream>
+#include <thread>
+#include <exception>
+#include <sstream>
+#include <torch/version.h>
+
+// CPU autocast with a device argument and native-bf16 detection (libtorch 2.4+).
+#if TORCH_VERSION_MAJOR > 2 || (TORCH_VERSION_MAJOR == 2 && TORCH_VERSION_MINOR >= 4)
+#define BF16_AUTOCAST_API 1
+#include <ATen/autocast_mode.h>
+#include <ATen/cpu/Utils.h>
+#else
+#define BF16_AUTOCAST_API 0
+#endif
 
 ModelInterface::ModelInterface(ResNet model,
                                std::shared_ptr<torch::optim::Optimizer> optimizer,
@@ -31,6 +48,11 @@ std::pair<std::vector<Chess::HistorySnapshot>, Chess::StateFlags>
 std::pair<ModelInterface::PolicyArray, float>
         ModelInterface::evaluateWithNetwork(const std::vector<Chess::State>& states)
 {
+    // Inference only: no autograd graph, BatchNorm is folded (running stats).
+    torch::NoGradGuard noGrad;
+    auto inference = inferenceModel();   // pinned: a concurrent publishWeights() can't swap it mid-call
+    const FusedResNet& net = inference->net;
+
     // Get encoded history and flags from helper
     auto [history, flags] = getEncodedSnapshotAndFlags(states);
 
@@ -45,8 +67,8 @@ std::pair<ModelInterface::PolicyArray, float>
             torch::kFloat)
             .clone();
 
-    // 3) forward: ResNetImpl::forward returns pair<logits, value>
-    auto [logits, value_t] = model_->forward(input);
+    // 3) forward: returns pair<logits, value>
+    auto [logits, value_t] = net.forward(input);
 
     // 4) softmax → policy
     auto probs = torch::softmax(logits, /*dim=*/1);
@@ -59,6 +81,229 @@ std::pair<ModelInterface::PolicyArray, float>
     return {policy, value};
 }
 
+std::vector<std::pair<ModelInterface::PolicyArray, float>>
+        ModelInterface::evaluateBatch(const std::vector<std::vector<Chess::State>>& batch)
+{
+    std::vector<std::pair<PolicyArray, float>> results(batch.size());
+    if (batch.empty()) return results;
+
+    // Inference only: folded (running-stat) BatchNorm keeps each position independent of the rest of the batch
+    torch::NoGradGuard noGrad;
+    auto inference = inferenceModel();   // pinned: a concurrent publishWeights() can't swap it mid-call
+    const FusedResNet& net = inference->net;
+
+    // 1) encode every position straight into one contiguous [B, C, H, W] buffer
+    std::vector<float> flat;
+    auto input = encodeBatch(batch, flat);
+
+    // 2) forward once for the whole batch
+    auto [logits, value_t] = net.forward(input);
+
+    // 3) softmax → policies, copied out through raw pointers rather than per-element item()
+    auto probs  = torch::softmax(logits, /*dim=*/1).contiguous().cpu();
+    auto values = value_t.contiguous().cpu();
+    const float* probsPtr  = probs.data_ptr<float>();
+    const float* valuesPtr = values.data_ptr<float>();
+
+    for (size_t b = 0; b < batch.size(); ++b) {
+        std::copy(probsPtr + b * ACTION_SIZE, probsPtr + (b + 1) * ACTION_SIZE, results[b].first.begin());
+        results[b].second = valuesPtr[b];
+    }
+    return results;
+}
+
+void ModelInterface::setQuantizedInference(bool enabled) {
+    quantizedInference_ = enabled;
+    fusedStale_.store(true, std::memory_order_release);
+}
+
+void ModelInterface::setCpuLayout(CpuLayout layout) {
+    cpuLayout_ = layout;
+    fusedStale_.store(true, std::memory_order_release);
+}
+
+double ModelInterface::benchmarkForward(int batchSize, int iterations) {
+    torch::NoGradGuard noGrad;
+    auto inference = inferenceModel();   // pinned: a concurrent publishWeights() can't swap it mid-call
+    const FusedResNet& net = inference->net;
+
+    int C = (14 * historyLength_) + 7;
+    auto device = model_->parameters().front().device();
+    auto input = torch::randn({batchSize, C, config_.row_count, config_.column_count},
+                              torch::TensorOptions().device(device));
+
+    // Warm-up: first calls pay for allocator growth and oneDNN primitive creation.
+    net.forward(input);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        auto [logits, value] = net.forward(input);
+        // Include the copy back, as evaluateBatch does
+        value.cpu();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(batchSize) * iterations / std::max(seconds, 1e-9);
+}
+
+double ModelInterface::layoutError(CpuLayout layout, int batchSize) {
+    torch::NoGradGuard noGrad;
+    FusedResNet reference, candidate;
+    {
+        std::lock_guard<std::mutex> lock(fusedMutex_);
+        reference.syncFrom(*model_, /*quantizeHeads=*/false, CpuLayout::Contiguous);
+        candidate.syncFrom(*model_, /*quantizeHeads=*/false, layout);
+    }
+
+    int C = (14 * historyLength_) + 7;
+    auto device = model_->parameters().front().device();
+    auto input = torch::randn({batchSize, C, config_.row_count, config_.column_count},
+                              torch::TensorOptions().device(device));
+
+    auto [refLogits, refValue] = reference.forward(input);
+    auto [logits, value]       = candidate.forward(input);
+    double policyError = (logits - refLogits).abs().max().item<double>();
+    double valueError  = (value - refValue).abs().max().item<double>();
+    return std::max(policyError, valueError);
+}
+
+ModelInterface::QuantizationReport
+        ModelInterface::compareQuantized(const std::vector<TrainingExample>& positions, int batchSize)
+{
+    QuantizationReport report;
+    if (positions.empty()) return report;
+
+    torch::NoGradGuard noGrad;
+    auto inference = inferenceModel();   // pinned: a concurrent publishWeights() can't swap it mid-call
+    const FusedResNet& net = inference->net;
+    if (!net.quantized()) return report;
+
+    int C = (14 * historyLength_) + 7;
+    const size_t perPosition = static_cast<size_t>(C) * config_.row_count * config_.column_count;
+    double klSum = 0.0, valueErrSum = 0.0;
+
+    for (size_t start = 0; start < positions.size(); start += batchSize) {
+        size_t end = std::min(positions.size(), start + static_cast<size_t>(batchSize));
+        std::vector<float> flat;
+        flat.reserve((end - start) * perPosition);
+        for (size_t i = start; i < end; ++i) {
+            flat.insert(flat.end(), positions[i].encodedState.begin(), positions[i].encodedState.end());
+        }
+        auto input = torch::from_blob(
+                flat.data(),
+                {static_cast<int64_t>(end - start), C, config_.row_count, config_.column_count},
+                torch::kFloat);
+
+        auto t0 = std::chrono::steady_clock::now();
+        auto [logits32, value32] = net.forward(input, /*useInt8=*/false);
+        auto t1 = std::chrono::steady_clock::now();
+        auto [logits8, value8] = net.forward(input, /*useInt8=*/true);
+        auto t2 = std::chrono::steady_clock::now();
+        report.fp32Ms += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        report.int8Ms += std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+        // KL(p32 || p8) = sum p32 * (log p32 - log p8), per position
+        auto logP32 = torch::log_softmax(logits32, /*dim=*/1);
+        auto logP8  = torch::log_softmax(logits8, /*dim=*/1);
+        auto kl = (logP32.exp() * (logP32 - logP8)).sum(1).contiguous().cpu();
+        auto valueErr = (value32 - value8).abs().view({-1}).contiguous().cpu();
+
+        const float* klPtr  = kl.data_ptr<float>();
+        const float* errPtr = valueErr.data_ptr<float>();
+        for (size_t i = 0; i < end - start; ++i) {
+            klSum += klPtr[i];
+            valueErrSum += errPtr[i];
+            report.maxPolicyKL   = std::max(report.maxPolicyKL, static_cast<double>(klPtr[i]));
+            report.maxValueError = std::max(report.maxValueError, static_cast<double>(errPtr[i]));
+        }
+    }
+
+    report.positions      = static_cast<int>(positions.size());
+    report.meanPolicyKL   = klSum / report.positions;
+    report.meanValueError = valueErrSum / report.positions;
+    return report;
+}
+
+torch::Tensor ModelInterface::encodeBatch(const std::vector<std::vector<Chess::State>>& batch,
+                                          std::vector<float>& buffer) const {
+    int C = (14 * historyLength_) + 7;
+    const size_t perPosition = static_cast<size_t>(C) * config_.row_count * config_.column_count;
+    buffer.clear();
+    buffer.reserve(batch.size() * perPosition);
+    for (const auto& states : batch) {
+        auto [history, flags] = getEncodedSnapshotAndFlags(states);
+        auto encoded = StateEncoder::encodeState(history, flags, historyLength_);
+        buffer.insert(buffer.end(), encoded.begin(), encoded.end());
+    }
+
+    // Wraps `buffer`, which must outlive the forward pass
+    return torch::from_blob(
+            buffer.data(),
+            {static_cast<int64_t>(batch.size()), C, config_.row_count, config_.column_count},
+            torch::kFloat);
+}
+
+ModelInterface::SparsePolicy ModelInterface::maskedSoftmax(const float* logits, const std::vector<int>& legalActions) {
+    SparsePolicy policy;
+    policy.reserve(legalActions.size());
+
+    float maxLogit = -std::numeric_limits<float>::infinity();
+    for (int action : legalActions) maxLogit = std::max(maxLogit, logits[action]);
+
+    // exp(l - max) keeps the largest term at 1, so the sum can't underflow or overflow.
+    float sum = 0.0f;
+    for (int action : legalActions) {
+        float e = std::exp(logits[action] - maxLogit);
+        policy.push_back({action, e});
+        sum += e;
+    }
+    for (auto& entry : policy) entry.prior /= sum;
+    return policy;
+}
+
+std::pair<ModelInterface::SparsePolicy, float>
+        ModelInterface::evaluateLegal(const std::vector<Chess::State>& states, const std::vector<int>& legalActions)
+{
+    auto results = evaluateBatchLegal({states}, {legalActions});
+    return std::move(results.front());
+}
+
+std::vector<std::pair<ModelInterface::SparsePolicy, float>>
+        ModelInterface::evaluateBatchLegal(const std::vector<std::vector<Chess::State>>& batch,
+                                           const std::vector<std::vector<int>>& legalActions)
+{
+    auto inference = inferenceModel();   // pinned: a concurrent publishWeights() can't swap it mid-call
+    return evaluateBatchLegal(batch, legalActions, *inference);
+}
+
+std::vector<std::pair<ModelInterface::SparsePolicy, float>>
+        ModelInterface::evaluateBatchLegal(const std::vector<std::vector<Chess::State>>& batch,
+                                           const std::vector<std::vector<int>>& legalActions,
+                                           const InferenceModel& model)
+{
+    assert(batch.size() == legalActions.size());
+    std::vector<std::pair<SparsePolicy, float>> results(batch.size());
+    if (batch.empty()) return results;
+
+    torch::NoGradGuard noGrad;
+    const FusedResNet& net = model.net;
+
+    std::vector<float> flat;
+    auto input = encodeBatch(batch, flat);
+    auto [logits, value_t] = net.forward(input);
+
+    // Raw logits straight to the host; the softmax only ever touches the legal entries.
+    auto logitsCpu = logits.contiguous().cpu();
+    auto values    = value_t.contiguous().cpu();
+    const float* logitsPtr = logitsCpu.data_ptr<float>();
+    const float* valuesPtr = values.data_ptr<float>();
+
+    for (size_t b = 0; b < batch.size(); ++b) {
+        results[b].first  = maskedSoftmax(logitsPtr + b * ACTION_SIZE, legalActions[b]);
+        results[b].second = valuesPtr[b];
+    }
+    return results;
+}
+
 ModelInterface::PolicyArray ModelInterface::maskAndNormalizePolicy(const PolicyArray& rawPolicy,
                                        const std::array<bool, ACTION_SIZE>& validMoves)
 {
@@ -83,116 +328,314 @@ ModelInterface::PolicyArray ModelInterface::maskAndNormalizePolicy(const PolicyA
     return out;
 }
 
-void ModelInterface::trainBatch(const std::vector<TrainingExample>& batch)
-{
-    // ensure training mode
-    model_->train(true);
+namespace {
+    // Enables bf16 autocast on the CPU for its lifetime and restores the previous state after.
+    // Parameters stay fp32; autocast only casts the inputs of eligible ops (convs, matmuls).
+    struct CpuBf16Autocast {
+        bool enabled;
+#if BF16_AUTOCAST_API
+        bool prevEnabled = false;
+        at::ScalarType prevDtype = at::kBFloat16;
+#endif
+
+        explicit CpuBf16Autocast(bool enable) : enabled(enable) {
+#if BF16_AUTOCAST_API
+            if (!enabled) return;
+            prevEnabled = at::autocast::is_autocast_enabled(at::kCPU);
+            prevDtype = at::autocast::get_autocast_dtype(at::kCPU);
+            at::autocast::set_autocast_enabled(at::kCPU, true);
+            at::autocast::set_autocast_dtype(at::kCPU, at::kBFloat16);
+            at::autocast::increment_nesting();
+#endif
+        }
+
+        ~CpuBf16Autocast() {
+#if BF16_AUTOCAST_API
+            if (!enabled) return;
+            // The cast weights are cached per forward; drop them once the outermost region closes.
+            if (at::autocast::decrement_nesting() == 0) at::autocast::clear_cache();
+            at::autocast::set_autocast_enabled(at::kCPU, prevEnabled);
+            at::autocast::set_autocast_dtype(at::kCPU, prevDtype);
+#endif
+        }
+    };
+}
+
+bool ModelInterface::setBf16Autocast(bool enabled) {
+    bf16Autocast_ = false;
+    if (!enabled) return false;
 
-    // build tensors
-    std::vector<torch::Tensor> states, policies, values;
-    states.reserve(batch.size());
-    policies.reserve(batch.size());
-    values.reserve(batch.size());
+#if BF16_AUTOCAST_API
+    if (!model_->parameters().front().device().is_cpu()) {
+        std::cerr << "[train] bf16 autocast is only used for CPU training, staying in fp32\n";
+    } else if (!at::cpu::is_avx512_bf16_supported()) {
+        // Without native bf16 instructions the casts cost more than the narrower math saves.
+        std::cerr << "[train] CPU has no native bf16 support, staying in fp32\n";
+    } else {
+        bf16Autocast_ = true;
+    }
+#else
+    std::cerr << "[train] bf16 autocast needs libtorch >= 2.4, staying in fp32\n";
+#endif
+    return bf16Autocast_;
+}
+
+void ModelInterface::setTrainReplicas(int count) {
+    replicas_.clear();
+    auto device = model_->parameters().front().device();
+    // model_ itself is replica 0; the others only need the same architecture, weights come from syncReplicas.
+    for (int i = 1; i < count; ++i) {
+        replicas_.push_back(ResNet(model_->config, model_->num_resBlocks, model_->num_hidden, device,
+                                   model_->policyHeadType));
+    }
+}
+
+void ModelInterface::syncReplicas(int count) {
+    torch::NoGradGuard noGrad;
+    auto masterParams  = model_->parameters();
+    auto masterBuffers = model_->buffers();
+    for (int r = 0; r < count; ++r) {
+        auto params  = replicas_[r]->parameters();
+        auto buffers = replicas_[r]->buffers();
+        for (size_t i = 0; i < params.size(); ++i)  params[i].copy_(masterParams[i]);
+        for (size_t i = 0; i < buffers.size(); ++i) buffers[i].copy_(masterBuffers[i]);
+        replicas_[r]->zero_grad();
+        replicas_[r]->train(true);
+    }
+}
+
+void ModelInterface::reduceReplicas(int count) {
+    torch::NoGradGuard noGrad;
+    auto masterParams  = model_->parameters();
+    auto masterBuffers = model_->buffers();
+    for (int r = 0; r < count; ++r) {
+        auto params  = replicas_[r]->parameters();
+        auto buffers = replicas_[r]->buffers();
+        // Every shard's loss is already weighted by its share of the batch, so the gradients simply add up.
+        for (size_t i = 0; i < params.size(); ++i) {
+            if (params[i].grad().defined()) masterParams[i].mutable_grad().add_(params[i].grad());
+        }
+        for (size_t i = 0; i < buffers.size(); ++i) {
+            if (buffers[i].is_floating_point()) masterBuffers[i].add_(buffers[i]);
+        }
+    }
+    // BN running statistics: mean over the replicas (num_batches_tracked keeps the master's count).
+    for (auto& buffer : masterBuffers) {
+        if (buffer.is_floating_point()) buffer.div_(static_cast<double>(count + 1));
+    }
+}
+
+void ModelInterface::accumulateGradients(ResNet& net, const TrainingExample* examples, int count,
+                                         int totalCount, int microBatchSize) {
+    const int micro = (microBatchSize > 0) ? std::min(microBatchSize, count) : count;
 
     int C = (14 * historyLength_) + 7;
     auto H = config_.row_count, W = config_.column_count;
+    const size_t stateSize = static_cast<size_t>(C) * H * W;
+
+    // Only one micro-batch of inputs and activations is alive at a time.
+    std::vector<float> stateBuffer, policyBuffer, valueBuffer;
+    stateBuffer.reserve(micro * stateSize);
+    policyBuffer.reserve(static_cast<size_t>(micro) * ACTION_SIZE);
+    valueBuffer.reserve(micro);
+
+    for (int start = 0; start < count; start += micro) {
+        int end = std::min(start + micro, count);
+        int n = end - start;
+
+        stateBuffer.clear();
+        policyBuffer.clear();
+        valueBuffer.clear();
+        for (int i = start; i < end; ++i) {
+            const TrainingExample& ex = examples[i];
+            stateBuffer.insert(stateBuffer.end(), ex.encodedState.begin(), ex.encodedState.end());
+            policyBuffer.insert(policyBuffer.end(), ex.policyTarget.begin(), ex.policyTarget.end());
+            valueBuffer.push_back(static_cast<float>(ex.valueTarget));
+        }
 
-    for (auto const& ex : batch) {
-        // state
-        auto s = torch::from_blob(
-                const_cast<float*>(ex.encodedState.data()),
-                {1, C, H, W},
-                torch::kFloat)
-                .clone();
-        states.push_back(std::move(s));
+        auto X = torch::from_blob(stateBuffer.data(), {n, C, H, W}, torch::kFloat);
+        auto P = torch::from_blob(policyBuffer.data(), {n, ACTION_SIZE}, torch::kFloat);
+        auto V = torch::from_blob(valueBuffer.data(), {n}, torch::kFloat);
+
+        // forward (bf16 compute when enabled), losses in fp32
+        torch::Tensor logits, preds;
+        {
+            CpuBf16Autocast autocast(bf16Autocast_);
+            std::tie(logits, preds) = net->forward(X);
+        }
+        logits = logits.to(torch::kFloat);
+        preds  = preds.to(torch::kFloat);
 
-        // policy target
-        auto p = torch::from_blob(
-                const_cast<float*>(ex.policyTarget.data()),
-                {ACTION_SIZE},
-                torch::kFloat)
-                .clone();
-        policies.push_back(std::move(p));
+        auto logP       = torch::log_softmax(logits, /*dim=*/1);
+        auto policyLoss = - (P * logP).sum(1).mean();
+        auto valueLoss  = torch::mse_loss(preds.view({-1}), V);
 
-        // value target
-        values.push_back(torch::tensor(ex.valueTarget, torch::kFloat));
+        // Weighted by the micro-batch's share, so the accumulated gradient is that of the batch mean.
+        auto loss = (policyLoss + valueLoss) * (static_cast<double>(n) / totalCount);
+        loss.backward();
     }
+}
 
-    auto X = torch::cat(states, 0);
-    auto P = torch::stack(policies, 0);
-    auto V = torch::stack(values,   0);
+void ModelInterface::trainBatch(const std::vector<TrainingExample>& batch, int microBatchSize)
+{
+    if (batch.empty()) return;
 
-    // forward
-    auto [logits, preds] = model_->forward(X);
+    // ensure training mode
+    model_->train(true);
+    optimizer_->zero_grad();
 
-    // losses
-    auto logP       = torch::log_softmax(logits, /*dim=*/1);
-    auto policyLoss = - (P * logP).sum(1).mean();
-    auto valueLoss  = torch::mse_loss(preds.view({-1}), V);
+    const int N = static_cast<int>(batch.size());
+    const int R = std::min(static_cast<int>(replicas_.size()) + 1, N);
 
-    auto loss = policyLoss + valueLoss;
+    if (R == 1) {
+        accumulateGradients(model_, batch.data(), N, N, microBatchSize);
+    } else {
+        // Data parallel: shard r of the batch runs on replica r (model_ for r = 0) on its own thread,
+        // then the gradients are summed into model_ and a single optimizer step is taken.
+        syncReplicas(R - 1);
+
+        std::vector<std::exception_ptr> errors(R);
+        auto runShard = [&](int r) {
+            try {
+                int begin = static_cast<int>(static_cast<long long>(N) * r / R);
+                int end   = static_cast<int>(static_cast<long long>(N) * (r + 1) / R);
+                accumulateGradients(r == 0 ? model_ : replicas_[r - 1], batch.data() + begin, end - begin,
+                                    N, microBatchSize);
+            } catch (...) {
+                errors[r] = std::current_exception();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(R - 1);
+        for (int r = 1; r < R; ++r) workers.emplace_back(runShard, r);
+        runShard(0);
+        for (auto& worker : workers) worker.join();
+
+        for (auto& error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+        reduceReplicas(R - 1);
+    }
 
-    // backward & step
-    optimizer_->zero_grad();
-    loss.backward();
     optimizer_->step();
 }
 
-ModelInterface::PolicyArray
-ModelInterface::addDirichletNoise(const PolicyArray& policy,
-                                  double dirichlet_epsilon,
-                                  double dirichlet_alpha)
+ModelInterface::InferenceHandle ModelInterface::foldInferenceModel(uint64_t version) {
+    auto inference = std::make_shared<InferenceModel>();
+    inference->net.syncFrom(*model_, quantizedInference_, cpuLayout_);
+    inference->version = version;
+    return inference;
+}
+
+ModelInterface::InferenceHandle ModelInterface::foldCandidate() {
+    std::lock_guard<std::mutex> lock(fusedMutex_);
+    return foldInferenceModel(modelVersion() + 1);
+}
+
+uint64_t ModelInterface::publish(InferenceHandle model) {
+    std::lock_guard<std::mutex> lock(fusedMutex_);
+    // Evaluations in flight finish on the version they pinned.
+    std::atomic_store(&inference_, std::move(model));
+    fusedStale_.store(false, std::memory_order_release);
+    return modelVersion();
+}
+
+uint64_t ModelInterface::publishWeights() {
+    return publish(foldCandidate());
+}
+
+uint64_t ModelInterface::modelVersion() const {
+    auto current = std::atomic_load(&inference_);
+    return current ? current->version : 0;
+}
+
+ModelInterface::InferenceHandle ModelInterface::inferenceModel() {
+    if (fusedStale_.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(fusedMutex_);
+        // Another search thread may have refolded while we waited.
+        if (fusedStale_.load(std::memory_order_relaxed)) {
+            // Same weights in a new layout / precision (or the very first fold): the version is kept.
+            auto current = std::atomic_load(&inference_);
+            std::atomic_store(&inference_, foldInferenceModel(current ? current->version : 0));
+            fusedStale_.store(false, std::memory_order_release);
+        }
+    }
+    return std::atomic_load(&inference_);
+}
+
+void ModelInterface::addDirichletNoise(SparsePolicy& priors,
+                                       double dirichlet_epsilon,
+                                       double dirichlet_alpha,
+                                       std::mt19937& rng)
 {
-    // 1) Sample α‑parameterized Gamma variables
-    std::mt19937_64                    rng{ std::random_device{}() };
-    std::gamma_distribution<double>    gammaDist(dirichlet_alpha, 1.0);
+    if (priors.empty()) return;
 
-    PolicyArray noise{};
+    // 1) Sample α‑parameterized Gamma variables, one per legal action
+    std::gamma_distribution<double> gammaDist(dirichlet_alpha, 1.0);
+    std::vector<double> noise(priors.size());
     double sum = 0.0;
-    for (int i = 0; i < (int)noise.size(); ++i) {
-        noise[i] = static_cast<float>(gammaDist(rng));
-        sum += noise[i];
+    for (auto& x : noise) {
+        x = gammaDist(rng);
+        sum += x;
     }
     // 2) Normalize to get Dirichlet draw
-    if (sum > 0.0) {
-        for (auto &x : noise) x = static_cast<float>(x / sum);
-    }
+    if (sum <= 0.0) return;
 
     // 3) Mix original policy with noise
-    PolicyArray out{};
-    for (int i = 0; i < (int)out.size(); ++i) {
-        out[i] = static_cast<float>(
-                (1.0 - dirichlet_epsilon) * policy[i]
-                + dirichlet_epsilon       * noise[i]
-        );
+    for (size_t i = 0; i < priors.size(); ++i) {
+        priors[i].prior = static_cast<float>((1.0 - dirichlet_epsilon) * priors[i].prior
+                                             + dirichlet_epsilon * noise[i] / sum);
     }
-    return out;
 }
 
-void ModelInterface::saveCheckpoint(int iteration) const {
-    // Find the true project root (go up from the build dir)
-    fs::path currentPath = fs::current_path();      // e.g., cmake-build-release/
-    fs::path projectRoot = currentPath.parent_path(); // Go up one level to alphazero_cpp/
+std::string ModelInterface::serializeModel() const {
+    torch::serialize::OutputArchive modelArchive;
+    model_->save(modelArchive);
+    std::ostringstream out;
+    modelArchive.save_to(out);
+    return out.str();
+}
 
-    // Path to checkpoints folder inside project
-    fs::path checkpointsFolder = projectRoot / "checkpoints";
+std::string ModelInterface::serializeOptimizer() const {
+    torch::serialize::OutputArchive optimArchive;
+    optimizer_->save(optimArchive);
+    std::ostringstream out;
+    optimArchive.save_to(out);
+    return out.str();
+}
 
-    if (!fs::exists(checkpointsFolder)) {
-        fs::create_directory(checkpointsFolder);
+void ModelInterface::loadCheckpoint(const std::string& modelPath, const std::string& optimPath,
+                                    const std::string& publishedPath) {
+    auto device = model_->parameters().front().device();
+    auto loadModel = [&](const std::string& path) {
+        std::cout << "[loadCheckpoint] Loading model from: " << path << "\n";
+        torch::serialize::InputArchive modelArchive;
+        modelArchive.load_from(path, device);
+        model_->load(modelArchive);
+    };
+
+    // A gated run serves older weights than it trains: publish those first, then load the training ones.
+    bool servesOtherWeights = !publishedPath.empty() && publishedPath != modelPath;
+    if (servesOtherWeights) {
+        loadModel(publishedPath);
+        uint64_t version = publishWeights();
+        std::cout << "[loadCheckpoint] Serving it as model version " << version << "\n";
     }
 
-    std::string modelPath = (checkpointsFolder / ("model_iter" + std::to_string(iteration) + ".pt")).string();
-    std::string optimPath = (checkpointsFolder / ("optim_iter" + std::to_string(iteration) + ".pt")).string();
+    loadModel(modelPath);
 
-    std::cout << "[saveCheckpoint] Saving model to: " << modelPath << "\n";
-    std::cout << "[saveCheckpoint] Saving optimizer to: " << optimPath << "\n";
+    if (!optimPath.empty()) {
+        std::cout << "[loadCheckpoint] Loading optimizer from: " << optimPath << "\n";
+        torch::serialize::InputArchive optimArchive;
+        optimArchive.load_from(optimPath, device);
+        optimizer_->load(optimArchive);
+    }
 
-    torch::serialize::OutputArchive modelArchive;
-    model_->save(modelArchive);
-    modelArchive.save_to(modelPath);
+    // Replicas resync on the next batch.
+    if (servesOtherWeights) return;
 
-    torch::serialize::OutputArchive optimArchive;
-    optimizer_->save(optimArchive);
-    optimArchive.save_to(optimPath);
+    // Hand the loaded weights to the evaluators.
+    uint64_t version = publishWeights();
+    std::cout << "[loadCheckpoint] Serving it as model version " << version << "\n";
 }
-
@@ -123,7 +123,7 @@ namespace MoveGeneration {
     // For each legal candidate move, we compute:
     //  - fromSquare, from the original piece bitboard difference.
     //  - toSquare similarly.
-    //  - shift = toSquare - fromSquare is then used with getMovementType() to encode a move.
+    //  - the (fromSquare, toSquare) pair is then encoded with MoveMapping::encodeAction (getMovementType, tabulated).
     // We then perform a temporary legality test using tempApplyActionToPieces.
     std::pair<std::array<bool, 4672>, bool> getValidMoves(const Chess::State &state) {
         std::array<bool, 4672> moveMask = {}; // all false by default
@@ -221,12 +221,10 @@ namespace MoveGeneration {
                     continue;
                 int fromSquare = bb_utils::ctz(from_bb);
                 int toSquare = bb_utils::ctz(to_bb);
-                int shift = toSquare - fromSquare;
-                // Use the MoveMapping function to resolve move type.
-                int moveType = MoveMapping::getMovementType(shift, fromSquare, pt);
-                if (moveType < 0)
+                // Resolve the move type (precomputed getMovementType, see MoveMapping::encodeTable).
+                int action = MoveMapping::encodeAction(fromSquare, toSquare, pt);
+                if (action < 0)
                     continue;
-                int action = moveType * 64 + fromSquare;
 
                 // 49-0-7, 55 --- 48
 
@@ -244,12 +242,10 @@ namespace MoveGeneration {
                         // If we're promoting, mask in those promotions (not the current action)
                         // PROMOTION LOGIC for white pawns reaching rank 8
                         if (pt == bb::WHITE_PAWN && (to_bb & RANK_8_MASK) != 0) {
-                            auto promoTypes = MoveMapping::getPromotionMovementTypes(pt, to_bb, shift);
-                            for (int promoMT: promoTypes) {
-                                if (promoMT < 0) continue;
+                            for (int promoAction: MoveMapping::encodePromotions(fromSquare, toSquare)) {
+                                if (promoAction < 0) continue;
                                 // legality already checked so mask in
-                                action = promoMT * 64 + fromSquare;
-                                moveMask[action] = true;
+                                moveMask[promoAction] = true;
                             }
                         }
                         // Otherwise, moving a piece normally and only one action to mask in
@@ -260,4 +256,13 @@ namespace MoveGeneration {
         }
         return {moveMask, false};
     }
+
+    std::vector<int> getLegalActions(const std::array<bool, 4672> &validMoves) {
+        std::vector<int> actions;
+        actions.reserve(64);
+        for (int action = 0; action < static_cast<int>(validMoves.size()); ++action) {
+            if (validMoves[action]) actions.push_back(action);
+        }
+        return actions;
+    }
 } // namespace MoveGeneration
@@ -1,4 +1,7 @@
 #include "Network.hpp"
+#include "MoveMapping.hpp"
+#include <iostream>
+#include <cassert>
 
 // -------------------- ResBlock Implementation --------------------
 ResBlockImpl::ResBlockImpl(int num_hidden) {
@@ -10,17 +13,18 @@ ResBlockImpl::ResBlockImpl(int num_hidden) {
 }
 
 torch::Tensor ResBlockImpl::forward(torch::Tensor x) {
-    auto residual = x.clone();
-    x = torch::relu(bn1(conv1(x)));
-    x = bn2(conv2(x));
-    x += residual;
-    x = torch::relu(x);
-    return x;
+    // x is only read below, so it can serve as the residual without a copy.
+    auto out = torch::relu(bn1(conv1(x)));
+    out = bn2(conv2(out));
+    out += x;
+    out = torch::relu(out);
+    return out;
 }
 
 // -------------------- ResNet Implementation --------------------
-ResNetImpl::ResNetImpl(const GameConfig& config, int num_resBlocks, int num_hidden, torch::Device device)
-        : config(config), num_resBlocks(num_resBlocks), num_hidden(num_hidden) {
+ResNetImpl::ResNetImpl(const GameConfig& config, int num_resBlocks, int num_hidden, torch::Device device,
+                       PolicyHeadType policyHeadType)
+        : config(config), num_resBlocks(num_resBlocks), num_hidden(num_hidden), policyHeadType(policyHeadType) {
 
     // Input channels: (14 * T) + 7.
     int input_channels = (14 * config.T) + 7;
@@ -38,16 +42,31 @@ ResNetImpl::ResNetImpl(const GameConfig& config, int num_resBlocks, int num_hidd
         backBone->push_back(ResBlock(num_hidden));
     }
 
-    // Policy head:
-    // Conv2d(num_hidden, 128, kernel_size=3, padding=1) -> BatchNorm2d -> ReLU -> Flatten -> Linear.
-    int flatten_size_policy = 128 * config.row_count * config.column_count;
-    policyHead = register_module("policyHead", torch::nn::Sequential(
-            torch::nn::Conv2d(torch::nn::Conv2dOptions(num_hidden, 128, /*kernel_size=*/3).padding(1)),
-            torch::nn::BatchNorm2d(128),
-            torch::nn::ReLU(),
-            torch::nn::Flatten(),
-            torch::nn::Linear(flatten_size_policy, config.action_size)
-    ));
+    if (policyHeadType == PolicyHeadType::Conv) {
+        // Policy head:
+        // Conv2d(num_hidden, num_hidden, kernel_size=3, padding=1) -> BatchNorm2d -> ReLU
+        // -> Conv2d(num_hidden, 73, kernel_size=1) -> Flatten.
+        // Flattening [73, 8, 8] gives index moveType*64 + square, which is exactly action = moveType*64 + fromSquare.
+        assert(MoveMapping::MOVEMENT_TYPE_COUNT * config.row_count * config.column_count == config.action_size);
+        policyHead = register_module("policyHead", torch::nn::Sequential(
+                torch::nn::Conv2d(torch::nn::Conv2dOptions(num_hidden, num_hidden, /*kernel_size=*/3).padding(1)),
+                torch::nn::BatchNorm2d(num_hidden),
+                torch::nn::ReLU(),
+                torch::nn::Conv2d(torch::nn::Conv2dOptions(num_hidden, MoveMapping::MOVEMENT_TYPE_COUNT, /*kernel_size=*/1)),
+                torch::nn::Flatten()
+        ));
+    } else {
+        // Policy head:
+        // Conv2d(num_hidden, 128, kernel_size=3, padding=1) -> BatchNorm2d -> ReLU -> Flatten -> Linear.
+        int flatten_size_policy = 128 * config.row_count * config.column_count;
+        policyHead = register_module("policyHead", torch::nn::Sequential(
+                torch::nn::Conv2d(torch::nn::Conv2dOptions(num_hidden, 128, /*kernel_size=*/3).padding(1)),
+                torch::nn::BatchNorm2d(128),
+                torch::nn::ReLU(),
+                torch::nn::Flatten(),
+                torch::nn::Linear(flatten_size_policy, config.action_size)
+        ));
+    }
 
     // Value head:
     // Conv2d(num_hidden, 64, kernel_size=3, padding=1) -> BatchNorm2d -> ReLU -> Flatten -> Linear -> Tanh.
@@ -76,3 +95,154 @@ std::pair<torch::Tensor, torch::Tensor> ResNetImpl::forward(torch::Tensor x) {
     auto value = valueHead->forward(x);
     return {policy, value};
 }
+
+// -------------------- FusedResNet Implementation --------------------
+FusedResNet::FusedConv FusedResNet::fold(const torch::nn::Conv2dImpl& conv, const torch::nn::BatchNorm2dImpl& bn) {
+    // BN(conv(x)) = gamma * (W*x + b - mean) / sqrt(var + eps) + beta
+    //             = (W * scale) * x + (b - mean) * scale + beta,   scale = gamma / sqrt(var + eps)
+    auto scale = bn.weight.detach() * (bn.running_var.detach() + bn.options.eps()).rsqrt();
+
+    FusedConv fused;
+    fused.weight = (conv.weight.detach() * scale.view({-1, 1, 1, 1})).contiguous();
+    fused.bias   = (conv.bias.detach() - bn.running_mean.detach()) * scale + bn.bias.detach();
+    return fused;
+}
+
+const char* cpuLayoutName(CpuLayout layout) {
+    switch (layout) {
+        case CpuLayout::Contiguous:   return "contiguous";
+        case CpuLayout::ChannelsLast: return "channels_last";
+        case CpuLayout::Mkldnn:       return "mkldnn";
+    }
+    return "?";
+}
+
+FusedResNet::FusedConv FusedResNet::toLayout(FusedConv c, int64_t padding) const {
+    switch (layout_) {
+        case CpuLayout::Contiguous:
+            break;
+        case CpuLayout::ChannelsLast:
+            c.weight = c.weight.contiguous(torch::MemoryFormat::ChannelsLast);
+            break;
+        case CpuLayout::Mkldnn:
+            // MKLDNN tensors, as mkldnn_convolution expects; the weight is reordered once here instead of on every call
+            c.weight = at::mkldnn_reorder_conv2d_weight(c.weight.to_mkldnn(), /*padding=*/{padding, padding},
+                                                        /*stride=*/{1, 1}, /*dilation=*/{1, 1}, /*groups=*/1);
+            c.bias = c.bias.to_mkldnn();
+            break;
+    }
+    return c;
+}
+
+torch::Tensor FusedResNet::conv(const torch::Tensor& x, const FusedConv& c, int64_t padding) const {
+    // Every conv in the network is stride 1: 3x3 with padding 1, or the Conv policy head's 1x1.
+    if (layout_ == CpuLayout::Mkldnn) {
+        return at::mkldnn_convolution(x, c.weight, c.bias, /*padding=*/{padding, padding}, /*stride=*/{1, 1},
+                                      /*dilation=*/{1, 1}, /*groups=*/1);
+    }
+    // Channels-last inputs and weights give channels-last outputs
+    return torch::conv2d(x, c.weight, c.bias, /*stride=*/{1, 1}, /*padding=*/{padding, padding});
+}
+
+torch::Tensor FusedResNet::toDense(const torch::Tensor& x) const {
+    return (layout_ == CpuLayout::Mkldnn) ? x.to_dense() : x;
+}
+
+FusedResNet::Int8Linear FusedResNet::quantizeLinear(const torch::Tensor& weight) {
+    Int8Linear q;
+    std::tie(q.weight, q.colOffsets, q.scale, q.zeroPoint) = at::fbgemm_linear_quantize_weight(weight);
+    q.packed = at::fbgemm_pack_quantized_matrix(q.weight);
+    return q;
+}
+
+void FusedResNet::syncFrom(ResNetImpl& net, bool quantizeHeads, CpuLayout layout) {
+    torch::NoGradGuard noGrad;
+
+    bool onCpu = net.startBlock->ptr(0)->as<torch::nn::Conv2d>()->weight.device().is_cpu();
+    layout_ = layout;
+    if (layout_ != CpuLayout::Contiguous && !onCpu) {
+        std::cerr << "[FusedResNet] " << cpuLayoutName(layout_) << " is a CPU layout, using contiguous\n";
+        layout_ = CpuLayout::Contiguous;
+    }
+    if (layout_ == CpuLayout::Mkldnn && !at::hasMKLDNN()) {
+        std::cerr << "[FusedResNet] libtorch was built without MKLDNN, using channels_last\n";
+        layout_ = CpuLayout::ChannelsLast;
+    }
+
+    // Layer layout is the one built in ResNetImpl's constructor.
+    start_ = toLayout(fold(*net.startBlock->ptr(0)->as<torch::nn::Conv2d>(),
+                           *net.startBlock->ptr(1)->as<torch::nn::BatchNorm2d>()));
+
+    blocks_.clear();
+    for (auto& module : *net.backBone) {
+        auto* block = module->as<ResBlock>();
+        blocks_.emplace_back(toLayout(fold(*block->conv1, *block->bn1)),
+                             toLayout(fold(*block->conv2, *block->bn2)));
+    }
+
+    policyHeadType_ = net.policyHeadType;
+    policyConv_ = toLayout(fold(*net.policyHead->ptr(0)->as<torch::nn::Conv2d>(),
+                                *net.policyHead->ptr(1)->as<torch::nn::BatchNorm2d>()));
+    policyPlanes_ = FusedConv{};
+    policyWeight_ = policyBias_ = torch::Tensor();
+    if (policyHeadType_ == PolicyHeadType::Conv) {
+        auto* planes = net.policyHead->ptr(3)->as<torch::nn::Conv2d>();
+        policyPlanes_ = toLayout({planes->weight.detach().clone(), planes->bias.detach().clone()}, /*padding=*/0);
+    } else {
+        auto* policyLinear = net.policyHead->ptr(4)->as<torch::nn::Linear>();
+        policyWeight_ = policyLinear->weight.detach().clone();
+        policyBias_   = policyLinear->bias.detach().clone();
+    }
+
+    quantizedHeads_ = false;
+    policyInt8_ = Int8Linear{};
+    if (quantizeHeads && policyHeadType_ == PolicyHeadType::Dense) {
+        if (onCpu && at::fbgemm_is_cpu_supported()) {
+            policyInt8_ = quantizeLinear(policyWeight_);
+            quantizedHeads_ = true;
+        } else {
+            std::cerr << "[FusedResNet] int8 heads need a CPU model with fbgemm support, keeping fp32\n";
+        }
+    }
+
+    valueConv_ = toLayout(fold(*net.valueHead->ptr(0)->as<torch::nn::Conv2d>(),
+                               *net.valueHead->ptr(1)->as<torch::nn::BatchNorm2d>()));
+    auto* valueLinear = net.valueHead->ptr(4)->as<torch::nn::Linear>();
+    valueWeight_ = valueLinear->weight.detach().clone();
+    valueBias_   = valueLinear->bias.detach().clone();
+
+    ready_ = true;
+}
+
+std::pair<torch::Tensor, torch::Tensor> FusedResNet::forward(torch::Tensor x, bool useInt8) const {
+    if (layout_ == CpuLayout::ChannelsLast) x = x.contiguous(torch::MemoryFormat::ChannelsLast);
+    else if (layout_ == CpuLayout::Mkldnn)  x = x.to_mkldnn();
+
+    x = conv(x, start_).relu_();
+
+    for (const auto& [c1, c2] : blocks_) {
+        auto out = conv(x, c1).relu_();
+        out = conv(out, c2);
+        // Residual add + ReLU in place on the fresh conv output
+        out.add_(x).relu_();
+        x = out;
+    }
+
+    // Back to dense NCHW order for the heads (flatten follows the logical C, H, W order).
+    torch::Tensor policy;
+    if (policyHeadType_ == PolicyHeadType::Conv) {
+        auto hidden = conv(x, policyConv_).relu_();
+        policy = toDense(conv(hidden, policyPlanes_, /*padding=*/0)).flatten(1);
+    } else {
+        auto policyFeatures = toDense(conv(x, policyConv_)).relu_().flatten(1);
+        if (quantizedHeads_ && useInt8) {
+            policy = at::fbgemm_linear_int8_weight_fp32_activation(
+                    policyFeatures, policyInt8_.weight, policyInt8_.packed, policyInt8_.colOffsets,
+                    policyInt8_.scale, policyInt8_.zeroPoint, policyBias_);
+        } else {
+            policy = torch::linear(policyFeatures, policyWeight_, policyBias_);
+        }
+    }
+    auto value  = torch::linear(toDense(conv(x, valueConv_)).relu_().flatten(1), valueWeight_, valueBias_).tanh_();
+    return {policy, value};
+}
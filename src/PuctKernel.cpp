@@ -0,0 +1,124 @@
+#include "PuctKernel.hpp"
+
+#include <limits>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define PUCT_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+namespace Puct {
+
+    int selectScalar(const float* priors, const int* visits, const float* valueSums, int count,
+                     float c, float sqrtParentVisits) {
+        int bestIdx = -1;
+        float bestScore = -std::numeric_limits<float>::infinity();
+        for (int i = 0; i < count; ++i) {
+            float visitsF = static_cast<float>(visits[i]);
+            float mean = (visits[i] == 0) ? 0.0f : valueSums[i] / visitsF;
+            float score = (1.0f - mean) / 2.0f + c * priors[i] * sqrtParentVisits / (1.0f + visitsF);
+            if (score > bestScore) {
+                bestScore = score;
+                bestIdx = i;
+            }
+        }
+        return bestIdx;
+    }
+
+#ifdef PUCT_AVX2_KERNEL
+
+    __attribute__((target("avx2")))
+    static int selectAVX2Impl(const float* priors, const int* visits, const float* valueSums, int count,
+                              float c, float sqrtParentVisits) {
+        const __m256 one   = _mm256_set1_ps(1.0f);
+        const __m256 two   = _mm256_set1_ps(2.0f);
+        const __m256 cVec  = _mm256_set1_ps(c);
+        const __m256 sqrtP = _mm256_set1_ps(sqrtParentVisits);
+        const __m256i step = _mm256_set1_epi32(8);
+
+        // Each lane keeps the first maximum among the children it sees (i = lane mod 8).
+        __m256  laneBest    = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+        __m256i laneBestIdx = _mm256_set1_epi32(-1);
+        __m256i idx         = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i v  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(visits + i));
+            __m256  vf = _mm256_cvtepi32_ps(v);
+
+            // Q: unvisited children get mean 0 (the division produced NaN/inf there).
+            __m256 mean = _mm256_div_ps(_mm256_loadu_ps(valueSums + i), vf);
+            __m256 unvisited = _mm256_castsi256_ps(_mm256_cmpeq_epi32(v, _mm256_setzero_si256()));
+            mean = _mm256_andnot_ps(unvisited, mean);
+            __m256 q = _mm256_div_ps(_mm256_sub_ps(one, mean), two);
+
+            // U, same operation order as the scalar loop
+            __m256 u = _mm256_mul_ps(_mm256_mul_ps(cVec, _mm256_loadu_ps(priors + i)), sqrtP);
+            u = _mm256_div_ps(u, _mm256_add_ps(one, vf));
+
+            __m256 score  = _mm256_add_ps(q, u);
+            __m256 better = _mm256_cmp_ps(score, laneBest, _CMP_GT_OQ);
+            laneBest    = _mm256_blendv_ps(laneBest, score, better);
+            laneBestIdx = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(laneBestIdx),
+                                                               _mm256_castsi256_ps(idx), better));
+            idx = _mm256_add_epi32(idx, step);
+        }
+
+        // Reduce the lanes: highest score, lowest index among equal scores.
+        alignas(32) float scores[8];
+        alignas(32) int   indices[8];
+        _mm256_store_ps(scores, laneBest);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(indices), laneBestIdx);
+
+        int bestIdx = -1;
+        float bestScore = -std::numeric_limits<float>::infinity();
+        for (int lane = 0; lane < 8; ++lane) {
+            if (indices[lane] == -1) continue;
+            if (scores[lane] > bestScore || (scores[lane] == bestScore && indices[lane] < bestIdx)) {
+                bestScore = scores[lane];
+                bestIdx = indices[lane];
+            }
+        }
+
+        // Tail: later indices only win with a strictly higher score, as in the scalar loop.
+        for (; i < count; ++i) {
+            float visitsF = static_cast<float>(visits[i]);
+            float mean = (visits[i] == 0) ? 0.0f : valueSums[i] / visitsF;
+            float score = (1.0f - mean) / 2.0f + c * priors[i] * sqrtParentVisits / (1.0f + visitsF);
+            if (score > bestScore) {
+                bestScore = score;
+                bestIdx = i;
+            }
+        }
+        return bestIdx;
+    }
+
+    bool hasAVX2() {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+
+    int selectAVX2(const float* priors, const int* visits, const float* valueSums, int count,
+                   float c, float sqrtParentVisits) {
+        if (!hasAVX2()) return selectScalar(priors, visits, valueSums, count, c, sqrtParentVisits);
+        return selectAVX2Impl(priors, visits, valueSums, count, c, sqrtParentVisits);
+    }
+
+#else
+
+    bool hasAVX2() { return false; }
+
+    int selectAVX2(const float* priors, const int* visits, const float* valueSums, int count,
+                   float c, float sqrtParentVisits) {
+        return selectScalar(priors, visits, valueSums, count, c, sqrtParentVisits);
+    }
+
+#endif
+
+    int select(const float* priors, const int* visits, const float* valueSums, int count,
+               float c, float sqrtParentVisits) {
+        // Below one vector the setup and lane reduction cost more than they save.
+        if (count < 8) return selectScalar(priors, visits, valueSums, count, c, sqrtParentVisits);
+        return selectAVX2(priors, visits, valueSums, count, c, sqrtParentVisits);
+    }
+}
@@ -0,0 +1,193 @@
+#include "SelfPlayGame.hpp"
+#include "StateTransition.hpp" // Provides getNextState, etc.
+#include "GameStatus.hpp"      // Provides evaluateState.
+#include "StateEncoder.hpp"
+#include "ModelInterface.hpp"
+
+#include <random>
+#include <cmath>
+
+// -------------------------- Helper: Random Sampling ------------------------
+// Helper: sample an action index from a probability distribution.
+static int sampleAction(const std::vector<float>& probs) {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    float total = 0.0f;
+    for (float p : probs) {
+        total += p;
+    }
+    std::uniform_real_distribution<> dis(0.0, total);
+    float r = dis(gen);
+    float cumulative = 0.0f;
+    for (size_t i = 0; i < probs.size(); ++i) {
+        cumulative += probs[i];
+        if (r <= cumulative)
+            return static_cast<int>(i);
+    }
+    return static_cast<int>(probs.size() - 1);
+}
+
+// ---------------------- SelfPlayGame Implementation ---------------------
+SelfPlayGame::SelfPlayGame(const AlphaZeroTrainer::TrainerArgs& args,
+                           ModelInterface& modelInterface,
+                           AlphaZeroTrainer::ResignStats& resignStats,
+                           MCTS::TreePool* treePool)
+        : args_(args),
+          resignStats_(resignStats),
+          modelInterface_(modelInterface),
+          mcts_(args, modelInterface, treePool) {
+    // Populate queue with initial state
+    for (int i = 0; i < args_.historyLength; ++i) {
+        currentTStates_.push(state_.pack());
+    }
+
+    // Insert root state's hash.
+    repetitionMap_[state_.zobrist_hash] = 1;
+    analysis_ = GameStatus::analyze(state_);
+
+    // Resignation: a fraction of games is played out regardless, so we can measure how often
+    // a resignation would have thrown away a draw or a win.
+    resignEnabled_ = args_.resign_threshold > -1.0;
+    if (resignEnabled_) {
+        std::mt19937 gen(std::random_device{}());
+        noResignGame_ = std::bernoulli_distribution(args_.no_resign_fraction)(gen);
+    }
+
+    // The first search waits on the evaluation of the starting position.
+    mcts_.beginSearch(state_, repetitionMap_, analysis_);
+}
+
+void SelfPlayGame::provideEvaluation(const std::vector<ActionPrior>& priors, float value) {
+    if (finished_) return;
+
+    mcts_.provideEvaluation(priors, value);
+
+    // A search can finish without needing the network again (e.g. only terminal leaves left),
+    // so keep playing until we're suspended or the game is over.
+    while (!mcts_.awaitingEvaluation()) {
+        if (playMove()) return;
+        mcts_.beginSearch(state_, repetitionMap_, analysis_);
+    }
+}
+
+bool SelfPlayGame::playMove() {
+    counter_++;
+    std::array<float, ACTION_SIZE> actionProbs = mcts_.searchResult();
+
+    // Create a record and fill it from the queue
+    SelfPlayRecord record;
+
+    /// Handle filling memory with the current entry
+    // Copy all states from currentTStates (FIFO) into the record
+    std::queue<Chess::PackedState> copyQueue = currentTStates_;  // work on a copy so we don't destroy original
+    while (!copyQueue.empty()) {
+        record.states.push_back(copyQueue.front());
+        copyQueue.pop();
+    }
+    // Add rest of the data
+    record.actionProbs = actionProbs;
+    record.player = player_;
+    // learn() only publishes new weights between self-play phases, so this is the version the whole search used.
+    record.modelVersion = modelInterface_.modelVersion();
+    // Push the full record into memory
+    memory_.push_back(record);
+
+    // Resign if the side to move considers its position lost.
+    if (resignEnabled_ && mcts_.rootValue() < args_.resign_threshold) {
+        if (!noResignGame_) {
+            resignStats_.resigned++;
+            finish(-1);
+            return true;
+        }
+        if (wouldHaveResigned_ == 0) wouldHaveResigned_ = player_;
+    }
+
+    int action;
+    if (args_.gumbel_root) {
+        // The Gumbel search already sampled its move; the improved policy is only the training target.
+        action = mcts_.bestAction();
+    } else {
+        // Adjust probabilities using temperature.
+        std::vector<float> temperedProbs(actionProbs.size());
+        float sum = 0.0f;
+        for (size_t i = 0; i < actionProbs.size(); ++i) {
+            temperedProbs[i] = std::pow(actionProbs[i], 1.0 / args_.temperature);
+            sum += temperedProbs[i];
+        }
+        for (auto &p : temperedProbs)
+            p /= sum;
+
+        // Sample an action.
+        action = sampleAction(temperedProbs);
+    }
+
+    // Update the state using a pure transition function and get clearMap flag
+    bool clearMap = StateTransition::getNextState(state_, action);
+
+    // If we should clear the repetition map, do so
+    if (clearMap) repetitionMap_.clear();
+
+    // Update currentTStates queue with new state
+    currentTStates_.pop();
+    currentTStates_.push(state_.pack());
+
+    // Update the repetition map with the new state's Zobrist hash.
+    repetitionMap_[state_.zobrist_hash] += 1;
+
+    // Update state.flags.repeated_state using a helper function
+    StateTransition::updateRepeatedStateFlag(state_, repetitionMap_.at(state_.zobrist_hash));
+
+    // Evaluate terminal state. The legal moves found here are the next search's root moves.
+    analysis_ = GameStatus::analyze(state_);
+    if (analysis_.terminal) {
+        finish(analysis_.value);
+        return true;
+    }
+
+    // Adjudicate trivial endings instead of playing them out.
+    if (args_.material_adjudication) {
+        auto [adjValue, adjudicated] = GameStatus::adjudicateMaterial(state_);
+        if (adjudicated) {
+            resignStats_.materialAdjudicated++;
+            finish(adjValue);
+            return true;
+        }
+    }
+
+    // Adjudicate a draw once the game gets too long.
+    if (args_.max_game_length > 0 && counter_ >= args_.max_game_length) {
+        resignStats_.lengthAdjudicated++;
+        finish(0);
+        return true;
+    }
+
+    player_ = -player_;
+    return false;
+}
+
+void SelfPlayGame::finish(int value) {
+    resignStats_.games++;
+    if (noResignGame_) {
+        resignStats_.noResignGames++;
+        if (wouldHaveResigned_ != 0) {
+            resignStats_.wouldHaveResigned++;
+            int resignerOutcome = (wouldHaveResigned_ == player_) ? value : -value;
+            if (resignerOutcome >= 0) resignStats_.falsePositives++;
+        }
+    }
+
+    // Build training examples from the history.
+    examples_.clear();
+    examples_.reserve(memory_.size());
+    std::vector<Chess::State> states;
+    for (const auto& rec : memory_) {
+        int outcome = (rec.player == player_) ? value : -value;
+        states.clear();
+        for (const Chess::PackedState& packed : rec.states) states.emplace_back(packed);
+        auto [history, flags] = ModelInterface::getEncodedSnapshotAndFlags(states);
+        examples_.push_back({StateEncoder::encodeState(history, flags, args_.historyLength), rec.actionProbs, outcome,
+                             rec.modelVersion});
+    }
+    memory_.clear();
+    finished_ = true;
+}
@@ -1,4 +1,5 @@
 #include "State.hpp"
+#include <cassert>
 #include <sstream>
 #include <random>
 #include <chrono>
@@ -113,6 +114,55 @@ namespace Chess {
             : pieces(pieces_), typeAtSquare(typeAtSquare_), flags(flags_), zobrist_hash(zobrist_hash_)
     {}
 
+// PackedState::flags layout: turn (bit 0), castle_rights (1-4), en_passant (5-12),
+// repeated_state (13-14), half_move_count (15-20), no_progress_side (21).
+    PackedState State::pack() const {
+        PackedState packed{};
+        for (int pt = 0; pt < 12; ++pt) packed.occupancy |= pieces[pt];
+        assert(bb_utils::popcount(packed.occupancy) <= 32);
+
+        // The i-th occupied square (in square order) gets nibble i.
+        for (int pt = 0; pt < 12; ++pt) {
+            uint64_t bb = pieces[pt];
+            while (bb) {
+                uint64_t sq_bb = bb_utils::pop_lsb(bb);
+                int index = bb_utils::popcount(packed.occupancy & (sq_bb - 1));
+                packed.types[index / 2] |= static_cast<uint8_t>(pt << (4 * (index % 2)));
+            }
+        }
+
+        packed.zobrist_hash = zobrist_hash;
+        packed.flags = static_cast<uint32_t>(flags.turn)
+                     | static_cast<uint32_t>(flags.castle_rights) << 1
+                     | static_cast<uint32_t>(flags.en_passant) << 5
+                     | static_cast<uint32_t>(flags.repeated_state) << 13
+                     | static_cast<uint32_t>(flags.half_move_count) << 15
+                     | static_cast<uint32_t>(flags.no_progress_side) << 21;
+        packed.total_move_count = flags.total_move_count;
+        return packed;
+    }
+
+    State::State(const PackedState& packed)
+            : pieces{}, flags{}, zobrist_hash(packed.zobrist_hash) {
+        typeAtSquare.fill(static_cast<SquareType>(bb::NO_PIECE));
+
+        uint64_t occupied = packed.occupancy;
+        for (int index = 0; occupied; ++index) {
+            uint64_t sq_bb = bb_utils::pop_lsb(occupied);
+            int pt = (packed.types[index / 2] >> (4 * (index % 2))) & 0xF;
+            pieces[pt] |= sq_bb;
+            typeAtSquare[bb_utils::ctz(sq_bb)] = static_cast<SquareType>(pt);
+        }
+
+        flags.turn             = packed.flags & 0x1;
+        flags.castle_rights    = (packed.flags >> 1) & 0xF;
+        flags.en_passant       = static_cast<uint8_t>((packed.flags >> 5) & 0xFF);
+        flags.repeated_state   = (packed.flags >> 13) & 0x3;
+        flags.half_move_count  = (packed.flags >> 15) & 0x3F;
+        flags.no_progress_side = (packed.flags >> 21) & 0x1;
+        flags.total_move_count = packed.total_move_count;
+    }
+
 // Compute the Zobrist hash for this state.
     uint64_t State::computeZobrist() const {
         uint64_t hash = 0;
@@ -9,14 +9,14 @@ namespace StateTransition {
 
         /// *** PREPROCESSING *** ///
 
-        // Decode the action.
-        int fromSquare = action % 64;
-        int moveType   = action / 64;
+        // Decode the action (precomputed, see MoveMapping::actionTable).
+        const MoveMapping::ActionInfo& info = MoveMapping::actionTable[action];
+        int fromSquare = info.from;
+        int moveType   = info.moveType;
 
         // Compute bitboard with one bit at fromSquare.
         uint64_t from_bb = 1ULL << fromSquare;
-        // Apply movement: use our Module A function.
-        uint64_t to_bb = MoveMapping::applyMovement(from_bb, moveType);
+        uint64_t to_bb = info.toBitboard();
 
         // Determine the moving piece type using the typeAtSquare array.
         int movingPieceType = static_cast<int>(currState.typeAtSquare[fromSquare]);
@@ -83,18 +83,10 @@ namespace StateTransition {
 
         // 4. Promotions: if a pawn reaches the last rank.
         int pawnPromoted = -1;
-        if (moveType == 64 || moveType == 65 || moveType == 66) {
+        if (info.special & MoveMapping::ACTION_PROMOTION) {
             currState.pieces[bb::WHITE_PAWN] &= ~to_bb;
-            currState.pieces[bb::WHITE_KNIGHT] |= to_bb;
-            pawnPromoted = bb::WHITE_KNIGHT;
-        } else if (moveType == 67 || moveType == 68 || moveType == 69) {
-            currState.pieces[bb::WHITE_PAWN] &= ~to_bb;
-            currState.pieces[bb::WHITE_BISHOP] |= to_bb;
-            pawnPromoted = bb::WHITE_BISHOP;
-        } else if (moveType == 70 || moveType == 71 || moveType == 72) {
-            currState.pieces[bb::WHITE_PAWN] &= ~to_bb;
-            currState.pieces[bb::WHITE_QUEEN] |= to_bb;
-            pawnPromoted = bb::WHITE_QUEEN;
+            currState.pieces[info.promotion] |= to_bb;
+            pawnPromoted = info.promotion;
         }
 
         /// *** UPDATING TYPEATSQUARE *** ///
@@ -247,14 +239,14 @@ namespace StateTransition {
 
         /// *** PREPROCESSING *** ///
 
-        // Decode the action.
-        int fromSquare = action % 64;
-        int moveType   = action / 64;
+        // Decode the action (precomputed, see MoveMapping::actionTable).
+        const MoveMapping::ActionInfo& info = MoveMapping::actionTable[action];
+        int fromSquare = info.from;
+        int moveType   = info.moveType;
 
         // Compute bitboard with one bit at fromSquare.
         uint64_t from_bb = 1ULL << fromSquare;
-        // Apply movement: use our Module A function.
-        uint64_t to_bb = MoveMapping::applyMovement(from_bb, moveType);
+        uint64_t to_bb = info.toBitboard();
 
         // Determine the moving piece type using the typeAtSquare array.
         int movingPieceType = static_cast<int>(currState.typeAtSquare[fromSquare]);
@@ -304,18 +296,9 @@ namespace StateTransition {
 
         // 4. Promotions: if a pawn reaches the last rank.
 //        int pawnPromoted = -1;
-        if (moveType == 64 || moveType == 65 || moveType == 66) {
-            newPieces[bb::WHITE_PAWN] &= ~to_bb;
-            newPieces[bb::WHITE_KNIGHT] |= to_bb;
-//            pawnPromoted = bb::WHITE_KNIGHT;
-        } else if (moveType == 67 || moveType == 68 || moveType == 69) {
-            newPieces[bb::WHITE_PAWN] &= ~to_bb;
-            newPieces[bb::WHITE_BISHOP] |= to_bb;
-//            pawnPromoted = bb::WHITE_BISHOP;
-        } else if (moveType == 70 || moveType == 71 || moveType == 72) {
+        if (info.special & MoveMapping::ACTION_PROMOTION) {
             newPieces[bb::WHITE_PAWN] &= ~to_bb;
-            newPieces[bb::WHITE_QUEEN] |= to_bb;
-//            pawnPromoted = bb::WHITE_QUEEN;
+            newPieces[info.promotion] |= to_bb;
         }
 
         return newPieces;
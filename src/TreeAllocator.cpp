@@ -0,0 +1,64 @@
+#include "TreeAllocator.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>   // sysconf
+
+namespace TreeMemory {
+
+    namespace {
+        std::atomic<bool> hugePages_{false};
+        std::atomic<bool> prefault_{false};
+
+        std::size_t roundUp(std::size_t bytes, std::size_t multiple) {
+            return (bytes + multiple - 1) / multiple * multiple;
+        }
+    }
+
+    void configure(bool hugePages, bool prefault) {
+        hugePages_.store(hugePages, std::memory_order_relaxed);
+        prefault_.store(prefault, std::memory_order_relaxed);
+    }
+
+    bool hugePages() { return hugePages_.load(std::memory_order_relaxed); }
+    bool prefault()  { return prefault_.load(std::memory_order_relaxed); }
+
+    void* allocate(std::size_t bytes) {
+        if (bytes < kLargeBlock) return ::operator new(bytes);
+
+        // Map one huge page more than needed and trim, so the block starts on a huge-page boundary
+        // (the kernel only backs aligned 2 MiB ranges with a huge page).
+        const std::size_t size = roundUp(bytes, kLargeBlock);
+        void* mapping = ::mmap(nullptr, size + kLargeBlock, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED) throw std::bad_alloc();
+
+        auto raw     = reinterpret_cast<std::uintptr_t>(mapping);
+        auto aligned = roundUp(raw, kLargeBlock);
+        if (aligned > raw) ::munmap(mapping, aligned - raw);
+        if (raw + kLargeBlock > aligned) ::munmap(reinterpret_cast<void*>(aligned + size), raw + kLargeBlock - aligned);
+        char* block = reinterpret_cast<char*>(aligned);
+
+#ifdef MADV_HUGEPAGE
+        if (hugePages()) ::madvise(block, size, MADV_HUGEPAGE);  // best effort: THP may be disabled
+#endif
+        if (prefault()) {
+            const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+            for (std::size_t offset = 0; offset < size; offset += page) {
+                static_cast<volatile char*>(block)[offset] = 0;
+            }
+        }
+        return block;
+    }
+
+    void deallocate(void* p, std::size_t bytes) {
+        if (!p) return;
+        if (bytes < kLargeBlock) {
+            ::operator delete(p);
+            return;
+        }
+        ::munmap(p, roundUp(bytes, kLargeBlock));
+    }
+}
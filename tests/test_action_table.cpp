@@ -0,0 +1,83 @@
+// tests/test_action_table.cpp
+
+#include "test_action_table.hpp"
+#include "MoveMapping.hpp"
+#include "bitboard/piece_type.hpp"
+
+#include <iostream>
+
+static int tests_run = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a,b) do { \
+    tests_run++; \
+    if ((a) != (b)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << " Assertion failed: " << #a << " != " << #b \
+                  << " (" << (a) << " vs " << (b) << ")\n"; \
+        tests_failed++; \
+    } \
+} while(0)
+
+// Decoding: what getNextState / tempApplyActionToPieces computed per action before the table.
+static void test_decode_matches_functions() {
+    for (int action = 0; action < MoveMapping::ACTION_COUNT; ++action) {
+        const MoveMapping::ActionInfo& info = MoveMapping::actionTable[action];
+        int fromSquare = action % 64;
+        int moveType   = action / 64;
+
+        ASSERT_EQ(static_cast<int>(info.from), fromSquare);
+        ASSERT_EQ(static_cast<int>(info.moveType), moveType);
+        ASSERT_EQ(info.toBitboard(), MoveMapping::applyMovement(1ULL << fromSquare, moveType));
+
+        int promotion = (moveType == 64 || moveType == 65 || moveType == 66) ? bb::WHITE_KNIGHT
+                      : (moveType == 67 || moveType == 68 || moveType == 69) ? bb::WHITE_BISHOP
+                      : (moveType == 70 || moveType == 71 || moveType == 72) ? bb::WHITE_QUEEN
+                      : bb::NO_PIECE;
+        ASSERT_EQ(static_cast<int>(info.promotion), promotion);
+        ASSERT_EQ((info.special & MoveMapping::ACTION_PROMOTION) != 0, promotion != bb::NO_PIECE);
+        ASSERT_EQ((info.special & MoveMapping::ACTION_CASTLE_TYPE) != 0, moveType == 15 || moveType == 43);
+        ASSERT_EQ((info.special & MoveMapping::ACTION_DOUBLE_PUSH) != 0, moveType == 1);
+    }
+}
+
+// Encoding: what getValidMoves computed per candidate move before the table.
+static void test_encode_matches_functions() {
+    for (int pt = bb::WHITE_PAWN; pt <= bb::WHITE_KING; ++pt) {
+        for (int from = 0; from < 64; ++from) {
+            for (int to = 0; to < 64; ++to) {
+                int shift = to - from;
+                int moveType = MoveMapping::getMovementType(shift, from, pt);
+                int expected = (moveType < 0) ? -1 : moveType * 64 + from;
+                int action = MoveMapping::encodeAction(from, to, pt);
+                ASSERT_EQ(action, expected);
+
+                // Round trip: an encoded move decodes to the same squares
+                if (action >= 0) {
+                    ASSERT_EQ(static_cast<int>(MoveMapping::actionTable[action].from), from);
+                    ASSERT_EQ(static_cast<int>(MoveMapping::actionTable[action].to), to);
+                }
+
+                // Promotions (getValidMoves only asks for pawns reaching the last rank)
+                auto types = MoveMapping::getPromotionMovementTypes(bb::WHITE_PAWN, 1ULL << to, shift);
+                auto actions = MoveMapping::encodePromotions(from, to);
+                for (int i = 0; i < 3; ++i) {
+                    ASSERT_EQ(actions[i], types[i] < 0 ? -1 : types[i] * 64 + from);
+                    if (actions[i] >= 0) {
+                        ASSERT_EQ(static_cast<int>(MoveMapping::actionTable[actions[i]].to), to);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void run_all_action_table_tests() {
+    test_decode_matches_functions();
+    test_encode_matches_functions();
+
+    std::cout << "\nTests run:    " << tests_run
+              << "\nFailures:     " << tests_failed << "\n";
+    if (tests_failed == 0) {
+        std::cout << "ALL ACTION TABLE TESTS PASSED ✅\n";
+    }
+}
@@ -0,0 +1,9 @@
+#ifndef TEST_ACTION_TABLE_HPP
+#define TEST_ACTION_TABLE_HPP
+
+// Checks the precomputed action tables of MoveMapping exhaustively against the functions they
+// tabulate (applyMovement, getMovementType, getPromotionMovementTypes), over all 4672 actions and
+// every (from, to, piece) combination.
+void run_all_action_table_tests();
+
+#endif // TEST_ACTION_TABLE_HPP
@@ -0,0 +1,158 @@
+// tests/test_puct.cpp
+
+#include "test_puct.hpp"
+#include "PuctKernel.hpp"
+#include "State.hpp"
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+static int tests_run = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a,b) do { \
+    tests_run++; \
+    if ((a) != (b)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << " Assertion failed: " << #a << " != " << #b \
+                  << " (" << (a) << " vs " << (b) << ")\n"; \
+        tests_failed++; \
+    } \
+} while(0)
+
+// What selection used to walk: one large node per child, statistics inside it.
+struct LegacyNode {
+    float prior;
+    int visit_count;
+    float value_sum;
+    Chess::State state;
+};
+
+// The original MCTS::ucbScore loop, sqrt(parentVisits) evaluated for every child.
+static int legacySelect(const std::vector<LegacyNode>& children, float c, int parentVisits) {
+    int bestIdx = -1;
+    float bestScore = -std::numeric_limits<float>::infinity();
+    for (size_t i = 0; i < children.size(); ++i) {
+        const LegacyNode& child = children[i];
+        float mean = (child.visit_count == 0) ? 0.0f : child.value_sum / static_cast<float>(child.visit_count);
+        float Q = (1 - mean) / 2;
+        float score = Q + c * child.prior * std::sqrt(static_cast<float>(parentVisits))
+                      / (1.0f + static_cast<float>(child.visit_count));
+        if (score > bestScore) {
+            bestScore = score;
+            bestIdx = static_cast<int>(i);
+        }
+    }
+    return bestIdx;
+}
+
+struct PackedChildren {
+    std::vector<float> priors;
+    std::vector<int> visits;
+    std::vector<float> valueSums;
+    std::vector<LegacyNode> legacy;
+    int parentVisits = 0;
+};
+
+// Random sibling set. `unvisitedShare` of the children keep zero visits, which makes exact ties likely.
+static PackedChildren randomChildren(std::mt19937& gen, int count, float unvisitedShare, bool uniformPriors) {
+    PackedChildren pc;
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_int_distribution<int> visitDist(1, 500);
+
+    float priorSum = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        float prior = uniformPriors ? 1.0f : unit(gen);
+        int visits = (unit(gen) < unvisitedShare) ? 0 : visitDist(gen);
+        float valueSum = (visits == 0) ? 0.0f : (2.0f * unit(gen) - 1.0f) * static_cast<float>(visits);
+        pc.priors.push_back(prior);
+        pc.visits.push_back(visits);
+        pc.valueSums.push_back(valueSum);
+        pc.parentVisits += visits;
+        priorSum += prior;
+    }
+    for (float& p : pc.priors) p /= priorSum;
+    pc.parentVisits += 1;
+
+    for (int i = 0; i < count; ++i) {
+        LegacyNode node;
+        node.prior = pc.priors[i];
+        node.visit_count = pc.visits[i];
+        node.value_sum = pc.valueSums[i];
+        pc.legacy.push_back(node);
+    }
+    return pc;
+}
+
+static void test_variants_match_legacy() {
+    std::mt19937 gen(1234);
+    const float c = 1.41f;
+
+    for (int trial = 0; trial < 20000; ++trial) {
+        int count = trial % 219;  // every legal-move count, including 0
+        float unvisitedShare = (trial % 3 == 0) ? 1.0f : (trial % 3 == 1) ? 0.5f : 0.0f;
+        bool uniformPriors = (trial % 7 == 0);
+        PackedChildren pc = randomChildren(gen, count, unvisitedShare, uniformPriors);
+
+        float sqrtParent = std::sqrt(static_cast<float>(pc.parentVisits));
+        int expected = legacySelect(pc.legacy, c, pc.parentVisits);
+
+        ASSERT_EQ(Puct::selectScalar(pc.priors.data(), pc.visits.data(), pc.valueSums.data(), count, c, sqrtParent), expected);
+        ASSERT_EQ(Puct::selectAVX2(pc.priors.data(), pc.visits.data(), pc.valueSums.data(), count, c, sqrtParent), expected);
+        ASSERT_EQ(Puct::select(pc.priors.data(), pc.visits.data(), pc.valueSums.data(), count, c, sqrtParent), expected);
+    }
+}
+
+// ns per selection of `fn` over `sets`, repeated until ~rounds * sets.size() calls.
+template <typename Fn>
+static double timeSelection(const std::vector<PackedChildren>& sets, int rounds, Fn fn) {
+    volatile int sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const auto& pc : sets) sink = sink + fn(pc);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return ns / (static_cast<double>(rounds) * static_cast<double>(sets.size()));
+}
+
+static void benchmark_selection() {
+    std::mt19937 gen(99);
+    const float c = 1.41f;
+
+    std::cout << "\nPUCT selection micro-benchmark (AVX2 " << (Puct::hasAVX2() ? "available" : "unavailable") << ")\n";
+    for (int count : {8, 35, 80, 218}) {
+        std::vector<PackedChildren> sets;
+        for (int i = 0; i < 256; ++i) sets.push_back(randomChildren(gen, count, 0.3f, false));
+        int rounds = 200000 / count + 1;
+
+        double legacy = timeSelection(sets, rounds, [&](const PackedChildren& pc) {
+            return legacySelect(pc.legacy, c, pc.parentVisits);
+        });
+        double scalar = timeSelection(sets, rounds, [&](const PackedChildren& pc) {
+            return Puct::selectScalar(pc.priors.data(), pc.visits.data(), pc.valueSums.data(), count,
+                                      c, std::sqrt(static_cast<float>(pc.parentVisits)));
+        });
+        double avx2 = timeSelection(sets, rounds, [&](const PackedChildren& pc) {
+            return Puct::selectAVX2(pc.priors.data(), pc.visits.data(), pc.valueSums.data(), count,
+                                    c, std::sqrt(static_cast<float>(pc.parentVisits)));
+        });
+
+        std::cout << "  " << count << " children: legacy " << legacy << " ns, packed scalar " << scalar
+                  << " ns, packed AVX2 " << avx2 << " ns\n";
+    }
+}
+
+void run_all_puct_tests() {
+    test_variants_match_legacy();
+
+    std::cout << "\nTests run:    " << tests_run
+              << "\nFailures:     " << tests_failed << "\n";
+    if (tests_failed == 0) {
+        std::cout << "ALL PUCT TESTS PASSED ✅\n";
+    }
+
+    benchmark_selection();
+}
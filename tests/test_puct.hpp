@@ -0,0 +1,8 @@
+#ifndef TEST_PUCT_HPP
+#define TEST_PUCT_HPP
+
+// Checks that every Puct::select variant picks the same child as the original per-node UCB loop,
+// then times them (micro-benchmark).
+void run_all_puct_tests();
+
+#endif // TEST_PUCT_HPP
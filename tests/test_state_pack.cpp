@@ -0,0 +1,70 @@
+// tests/test_state_pack.cpp
+
+#include "test_state_pack.hpp"
+#include "State.hpp"
+#include "StateTransition.hpp"
+#include "MoveGeneration.hpp"
+#include "GameStatus.hpp"
+
+#include <iostream>
+#include <random>
+
+static int tests_run = 0;
+static int tests_failed = 0;
+
+#define ASSERT_EQ(a,b) do { \
+    tests_run++; \
+    if ((a) != (b)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << " Assertion failed: " << #a << " != " << #b \
+                  << " (" << (a) << " vs " << (b) << ")\n"; \
+        tests_failed++; \
+    } \
+} while(0)
+
+static void check_round_trip(const Chess::State& state) {
+    Chess::PackedState packed = state.pack();
+    Chess::State unpacked(packed);
+
+    ASSERT_EQ(unpacked.pieces == state.pieces, true);
+    ASSERT_EQ(unpacked.typeAtSquare == state.typeAtSquare, true);
+    ASSERT_EQ(unpacked.zobrist_hash, state.zobrist_hash);
+    ASSERT_EQ(unpacked.flags.turn, state.flags.turn);
+    ASSERT_EQ(unpacked.flags.castle_rights, state.flags.castle_rights);
+    ASSERT_EQ(static_cast<int>(unpacked.flags.en_passant), static_cast<int>(state.flags.en_passant));
+    ASSERT_EQ(unpacked.flags.repeated_state, state.flags.repeated_state);
+    ASSERT_EQ(unpacked.flags.half_move_count, state.flags.half_move_count);
+    ASSERT_EQ(unpacked.flags.no_progress_side, state.flags.no_progress_side);
+    ASSERT_EQ(unpacked.flags.total_move_count, state.flags.total_move_count);
+    ASSERT_EQ(unpacked.pack() == packed, true);
+}
+
+// Random games cover captures, castling, en passant and promotions. Random play rarely repeats a
+// position, so every position is also checked with each repeated_state value (0, 1 and 2); on a copy,
+// since a third occurrence would end the game.
+static void test_random_games_round_trip() {
+    std::mt19937 rng(7);
+    for (int game = 0; game < 50; ++game) {
+        Chess::State state;
+        for (int ply = 0; ply < 200; ++ply) {
+            for (unsigned repeated = 0; repeated < 3; ++repeated) {
+                Chess::State copy = state;
+                copy.flags.repeated_state = repeated;
+                check_round_trip(copy);
+            }
+            GameStatus::Analysis analysis = GameStatus::analyze(state);
+            if (analysis.terminal) break;
+            std::vector<int> actions = MoveGeneration::getLegalActions(analysis.validMoves);
+            StateTransition::getNextState(state, actions[rng() % actions.size()]);
+        }
+    }
+}
+
+void run_all_state_pack_tests() {
+    test_random_games_round_trip();
+
+    std::cout << "\nTests run:    " << tests_run
+              << "\nFailures:     " << tests_failed << "\n";
+    if (tests_failed == 0) {
+        std::cout << "ALL STATE PACK TESTS PASSED ✅\n";
+    }
+}
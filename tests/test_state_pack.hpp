@@ -0,0 +1,8 @@
+#ifndef TEST_STATE_PACK_HPP
+#define TEST_STATE_PACK_HPP
+
+// Checks that State::pack() and the PackedState constructor round-trip every position of seeded
+// random games: pieces, typeAtSquare, hash and every flag field, and that repacking is stable.
+void run_all_state_pack_tests();
+
+#endif // TEST_STATE_PACK_HPP